@@ -1,5 +1,6 @@
 #include "SiPM.h"
 #include <benchmark/benchmark.h>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <vector>
@@ -7,14 +8,19 @@
 class BenchmarkRandom : public benchmark::Fixture {
 public:
   sipm::SiPMRng::Xorshift256plus m_rng;
+  sipm::SiPMRng::Philox4x32 m_philox;
   sipm::SiPMRandom m_random;
+  sipm::SiPMRandom m_counterRandom{sipm::SiPMRandom::Engine::kPhilox4x32};
 
   void SetUp(const ::benchmark::State& state) {
     m_rng.seed();
+    m_philox.seed();
     // Heat up cache
     for (size_t i = 0; i < 1024; i++) {
       m_rng();
+      m_philox();
       m_random.Rand();
+      m_counterRandom.Rand();
     }
   }
 
@@ -27,6 +33,12 @@ BENCHMARK_F(BenchmarkRandom, Rng)(benchmark::State& st) {
   }
 }
 
+BENCHMARK_F(BenchmarkRandom, PhiloxRng)(benchmark::State& st) {
+  for (auto _ : st) {
+    benchmark::DoNotOptimize(m_philox());
+  }
+}
+
 BENCHMARK_F(BenchmarkRandom, SingleRandomDouble)(benchmark::State& st) {
   for (auto _ : st) {
     benchmark::DoNotOptimize(m_random.Rand());
@@ -69,6 +81,34 @@ BENCHMARK_F(BenchmarkRandom, SingleExponential)(benchmark::State& st) {
   }
 }
 
+BENCHMARK_F(BenchmarkRandom, SingleExponentialTrunc)(benchmark::State& st) {
+  for (auto _ : st) {
+    benchmark::DoNotOptimize(m_random.randExponentialTrunc(10, 5));
+  }
+}
+
+// Rejection of untruncated values, as done before randExponentialTrunc, with
+// a truncation of range(0) / 10 times the mean
+BENCHMARK_DEFINE_F(BenchmarkRandom, ExponentialRejection)(benchmark::State& st) {
+  const double max = st.range(0) * 0.1 * 10;
+  for (auto _ : st) {
+    double x;
+    do {
+      x = m_random.randExponential(10);
+    } while (x > max);
+    benchmark::DoNotOptimize(x);
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, ExponentialRejection)->Arg(1)->Arg(10)->Arg(100);
+
+BENCHMARK_DEFINE_F(BenchmarkRandom, ExponentialTrunc)(benchmark::State& st) {
+  const double max = st.range(0) * 0.1 * 10;
+  for (auto _ : st) {
+    benchmark::DoNotOptimize(m_random.randExponentialTrunc(10, max));
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, ExponentialTrunc)->Arg(1)->Arg(10)->Arg(100);
+
 BENCHMARK_DEFINE_F(BenchmarkRandom, MultipleRng)(benchmark::State& st) {
   for (auto _ : st) {
     uint64_t* x = (uint64_t*)aligned_alloc(64,st.range(0)*sizeof(uint64_t));
@@ -79,6 +119,30 @@ BENCHMARK_DEFINE_F(BenchmarkRandom, MultipleRng)(benchmark::State& st) {
 }
 BENCHMARK_REGISTER_F(BenchmarkRandom, MultipleRng)->RangeMultiplier(2)->Range(8, 1 << 16)->Complexity(benchmark::oN);
 
+BENCHMARK_DEFINE_F(BenchmarkRandom, MultiplePhiloxRng)(benchmark::State& st) {
+  for (auto _ : st) {
+    uint64_t* x = (uint64_t*)aligned_alloc(64,st.range(0)*sizeof(uint64_t));
+    m_philox.getRand(x,st.range(0));
+    free(x);
+  }
+  st.SetComplexityN(st.range(0));
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MultiplePhiloxRng)
+  ->RangeMultiplier(2)
+  ->Range(8, 1 << 16)
+  ->Complexity(benchmark::oN);
+
+// Cost of selecting the stream of a new event and drawing from it
+BENCHMARK_DEFINE_F(BenchmarkRandom, PhiloxNewStream)(benchmark::State& st) {
+  uint64_t eventId = 0;
+  for (auto _ : st) {
+    m_counterRandom.setStream(eventId++);
+    benchmark::DoNotOptimize(m_counterRandom.Rand(st.range(0)));
+  }
+  st.SetComplexityN(st.range(0));
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, PhiloxNewStream)->RangeMultiplier(4)->Range(1, 1 << 12)->Complexity(benchmark::oN);
+
 BENCHMARK_DEFINE_F(BenchmarkRandom, MultipleRandomDouble)(benchmark::State& st) {
   for (auto _ : st) {
     benchmark::DoNotOptimize(m_random.Rand(st.range(0)));
@@ -134,5 +198,208 @@ BENCHMARK_REGISTER_F(BenchmarkRandom, MultipleGaussianFloat)
   ->Range(1, 1 << 12)
   ->Complexity(benchmark::oN);
 
+// Box-Muller calling libm, reference for the vectorized version
+BENCHMARK_DEFINE_F(BenchmarkRandom, MultipleGaussianDoubleBoxMuller)(benchmark::State& st) {
+  std::vector<double> out(st.range(0));
+  for (auto _ : st) {
+    m_random.Rand(out.size(), out.data());
+    for (uint32_t i = 0; i + 1 < out.size(); i += 2) {
+      const double r = std::sqrt(-2 * std::log(1 - out[i]));
+      const double phi = 2 * M_PI * out[i + 1];
+      out[i] = std::sin(phi) * r;
+      out[i + 1] = std::cos(phi) * r;
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  st.SetComplexityN(st.range(0));
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MultipleGaussianDoubleBoxMuller)
+  ->RangeMultiplier(2)
+  ->Range(1, 1 << 12)
+  ->Complexity(benchmark::oN);
+
+// Reference for the ziggurat: inversion of the CDF
+BENCHMARK_F(BenchmarkRandom, SingleExponentialInversion)(benchmark::State& st) {
+  for (auto _ : st) {
+    benchmark::DoNotOptimize(-std::log(1 - m_random.Rand()) * 10);
+  }
+}
+
+BENCHMARK_F(BenchmarkRandom, SingleExponentialFloat)(benchmark::State& st) {
+  for (auto _ : st) {
+    benchmark::DoNotOptimize(m_random.randExponentialF(10));
+  }
+}
+
+BENCHMARK_DEFINE_F(BenchmarkRandom, MultipleExponentialDouble)(benchmark::State& st) {
+  for (auto _ : st) {
+    benchmark::DoNotOptimize(m_random.randExponential(10, st.range(0)));
+  }
+  st.SetComplexityN(st.range(0));
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MultipleExponentialDouble)
+  ->RangeMultiplier(2)
+  ->Range(1, 1 << 12)
+  ->Complexity(benchmark::oN);
+
+BENCHMARK_DEFINE_F(BenchmarkRandom, MultipleExponentialDoubleInversion)(benchmark::State& st) {
+  std::vector<double> out(st.range(0));
+  for (auto _ : st) {
+    m_random.Rand(out.size(), out.data());
+    for (double& x : out) {
+      x = -std::log(1 - x) * 10;
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  st.SetComplexityN(st.range(0));
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MultipleExponentialDoubleInversion)
+  ->RangeMultiplier(2)
+  ->Range(1, 1 << 12)
+  ->Complexity(benchmark::oN);
+
+BENCHMARK_DEFINE_F(BenchmarkRandom, MultipleExponentialFloat)(benchmark::State& st) {
+  std::vector<float> out(st.range(0));
+  for (auto _ : st) {
+    m_random.randExponentialF(10, out.size(), out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+  st.SetComplexityN(st.range(0));
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MultipleExponentialFloat)
+  ->RangeMultiplier(2)
+  ->Range(1, 1 << 12)
+  ->Complexity(benchmark::oN);
+
+BENCHMARK_DEFINE_F(BenchmarkRandom, MultipleExponentialTrunc)(benchmark::State& st) {
+  // Means and truncations as afterpulses in a signal of 500 samples
+  std::vector<double> mu(st.range(0)), max(st.range(0)), out(st.range(0));
+  for (uint32_t i = 0; i < mu.size(); ++i) {
+    mu[i] = i & 1 ? 10 : 80;
+    max[i] = m_random.Rand() * 500;
+  }
+  for (auto _ : st) {
+    m_random.randExponentialTrunc(mu.data(), max.data(), out.size(), out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+  st.SetComplexityN(st.range(0));
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MultipleExponentialTrunc)
+  ->RangeMultiplier(2)
+  ->Range(1, 1 << 12)
+  ->Complexity(benchmark::oN);
+
+BENCHMARK_DEFINE_F(BenchmarkRandom, MultipleGaussianFloatPhilox)(benchmark::State& st) {
+  for (auto _ : st) {
+    benchmark::DoNotOptimize(m_counterRandom.randGaussianF(0, 1, st.range(0)));
+  }
+  st.SetComplexityN(st.range(0));
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MultipleGaussianFloatPhilox)
+  ->RangeMultiplier(2)
+  ->Range(1, 1 << 12)
+  ->Complexity(benchmark::oN);
+
+// Vectorized kernels of SiPMMath against loops calling libm
+BENCHMARK_DEFINE_F(BenchmarkRandom, MathLogFloat)(benchmark::State& st) {
+  std::vector<float> x = m_random.RandF(st.range(0));
+  std::vector<float> out(x.size());
+  for (float& v : x) {
+    v += 0x1p-24f;
+  }
+  for (auto _ : st) {
+    if (st.range(1)) {
+      sipm::SiPMMath::log(x.data(), x.size(), out.data());
+    } else {
+      for (uint32_t i = 0; i < x.size(); ++i) {
+        out[i] = std::log(x[i]);
+      }
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MathLogFloat)->ArgsProduct({{4096}, {0, 1}});
+
+BENCHMARK_DEFINE_F(BenchmarkRandom, MathSinCosFloat)(benchmark::State& st) {
+  std::vector<float> x = m_random.RandF(st.range(0));
+  std::vector<float> s(x.size()), c(x.size());
+  for (float& v : x) {
+    v *= 2 * M_PI;
+  }
+  for (auto _ : st) {
+    if (st.range(1)) {
+      sipm::SiPMMath::sincos(x.data(), x.size(), s.data(), c.data());
+    } else {
+      for (uint32_t i = 0; i < x.size(); ++i) {
+        s[i] = std::sin(x[i]);
+        c[i] = std::cos(x[i]);
+      }
+    }
+    benchmark::DoNotOptimize(s.data());
+    benchmark::DoNotOptimize(c.data());
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MathSinCosFloat)->ArgsProduct({{4096}, {0, 1}});
+
+BENCHMARK_DEFINE_F(BenchmarkRandom, MathLogDouble)(benchmark::State& st) {
+  std::vector<double> x = m_random.Rand(st.range(0));
+  std::vector<double> out(x.size());
+  for (double& v : x) {
+    v = 1 - v;
+  }
+  for (auto _ : st) {
+    if (st.range(1)) {
+      sipm::SiPMMath::log(x.data(), x.size(), out.data());
+    } else {
+      for (uint32_t i = 0; i < x.size(); ++i) {
+        out[i] = std::log(x[i]);
+      }
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MathLogDouble)->ArgsProduct({{4096}, {0, 1}});
+
+BENCHMARK_DEFINE_F(BenchmarkRandom, MathExpDouble)(benchmark::State& st) {
+  std::vector<double> x = m_random.Rand(st.range(0));
+  std::vector<double> out(x.size());
+  for (double& v : x) {
+    v *= -40;
+  }
+  for (auto _ : st) {
+    if (st.range(1)) {
+      sipm::SiPMMath::exp(x.data(), x.size(), out.data());
+    } else {
+      for (uint32_t i = 0; i < x.size(); ++i) {
+        out[i] = std::exp(x[i]);
+      }
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, MathExpDouble)->ArgsProduct({{4096}, {0, 1}});
+
+// Block generators with each backend of SiPMDispatch (0 scalar, 1 AVX2,
+// 2 AVX512), third argument selects the generator (0 xoshiro, 1 philox)
+BENCHMARK_DEFINE_F(BenchmarkRandom, DispatchRng)(benchmark::State& st) {
+  const auto backend = static_cast<sipm::SiPMDispatch::Backend>(st.range(1));
+  if (!sipm::SiPMDispatch::setBackend(backend)) {
+    st.SkipWithError("Backend not supported");
+    return;
+  }
+  std::vector<uint64_t> out(st.range(0));
+  for (auto _ : st) {
+    if (st.range(2)) {
+      m_philox.getRand(out.data(), out.size());
+    } else {
+      m_rng.getRand(out.data(), out.size());
+    }
+    benchmark::DoNotOptimize(out.data());
+  }
+  sipm::SiPMDispatch::setBackend(sipm::SiPMDispatch::bestBackend());
+  st.SetItemsProcessed(st.iterations() * st.range(0));
+}
+BENCHMARK_REGISTER_F(BenchmarkRandom, DispatchRng)->ArgsProduct({{4096}, {0, 1, 2}, {0, 1}});
+
 // Run the benchmark
 BENCHMARK_MAIN();
@@ -1,7 +1,9 @@
 #include "../include/SiPM.h"
 #include "SiPMProperties.h"
 #include <benchmark/benchmark.h>
+#include <cmath>
 #include <cstdint>
+#include <thread>
 #include <vector>
 
 class BenchmarkSensor : public benchmark::Fixture {
@@ -29,6 +31,16 @@ BENCHMARK_F(BenchmarkSensor, DefaultNoLightSim)(benchmark::State& st) {
   }
 }
 
+BENCHMARK_F(BenchmarkSensor, NoiseBankNoLightSim)(benchmark::State& st) {
+  sipm::SiPMProperties prop;
+  prop.setNoiseMode(sipm::SiPMProperties::NoiseMode::kBank);
+  m_sensor.setProperties(prop);
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.runEvent();
+  }
+}
+
 BENCHMARK_F(BenchmarkSensor, DefaultNoNoiseNoLightSim)(benchmark::State& st) {
   auto prop = m_sensor.properties();
   prop.setDcrOff();
@@ -74,7 +86,7 @@ BENCHMARK_REGISTER_F(BenchmarkSensor, DefaultNoNoiseLightSim)->RangeMultiplier(2
 BENCHMARK_DEFINE_F(BenchmarkSensor, DefaultWlenLightSim)(benchmark::State& st) {
   auto prop = sipm::SiPMProperties();
   const std::vector<double> wlen = {300, 400, 500, 600, 700};
-  const std::vector<double> pde = {0.1, 0.3, 0.2, 0.1};
+  const std::vector<double> pde = {0.1, 0.3, 0.2, 0.1, 0.05};
   prop.setPdeSpectrum(wlen, pde);
   m_sensor.setProperties(prop);
   for (auto _ : st) {
@@ -89,6 +101,150 @@ BENCHMARK_DEFINE_F(BenchmarkSensor, DefaultWlenLightSim)(benchmark::State& st) {
 }
 BENCHMARK_REGISTER_F(BenchmarkSensor, DefaultWlenLightSim)->RangeMultiplier(2)->Range(1, 1 << 12);
 
+// Many photons with low flat PDE for each hit distribution: cost is dominated
+// by photoelectrons generation
+BENCHMARK_DEFINE_F(BenchmarkSensor, SimplePdeManyPhotons)(benchmark::State& st) {
+  auto prop = sipm::SiPMProperties();
+  prop.setPde(0.01);
+  prop.setDcrOff();
+  prop.setHitDistribution(static_cast<sipm::SiPMProperties::HitDistribution>(st.range(1)));
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(100, 10, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, SimplePdeManyPhotons)
+  ->ArgsProduct({{10000, 100000}, {0, 1, 2}})
+  ->Unit(benchmark::kMicrosecond);
+
+// Dark noise only at high DCR over long signal windows
+BENCHMARK_DEFINE_F(BenchmarkSensor, HighDcrNoLightSim)(benchmark::State& st) {
+  auto prop = sipm::SiPMProperties();
+  prop.setDcr(10e6);
+  prop.setSignalLength(st.range(0));
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setNoiseMode(sipm::SiPMProperties::NoiseMode::kBank);
+  m_sensor.setProperties(prop);
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, HighDcrNoLightSim)
+  ->Arg(500)
+  ->Arg(5000)
+  ->Arg(50000)
+  ->Unit(benchmark::kMicrosecond);
+
+// Long cascades of correlated noise: xt and ap given by range(0) in percent
+BENCHMARK_DEFINE_F(BenchmarkSensor, HighXtCascade)(benchmark::State& st) {
+  auto prop = sipm::SiPMProperties();
+  prop.setXt(st.range(0) * 0.01);
+  prop.setAp(st.range(0) * 0.01);
+  prop.setDXt(0.1);
+  prop.setNoiseMode(sipm::SiPMProperties::NoiseMode::kBank);
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(100, 10, 1000);
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, HighXtCascade)->Arg(0)->Arg(5)->Arg(15)->Arg(30)->Unit(benchmark::kMicrosecond);
+
+// Same as SimplePdeManyPhotons with the position of each photon given
+BENCHMARK_DEFINE_F(BenchmarkSensor, PositionPdeManyPhotons)(benchmark::State& st) {
+  auto prop = sipm::SiPMProperties();
+  prop.setPde(0.01);
+  prop.setDcrOff();
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(100, 10, st.range(0));
+  const std::vector<double> w;
+  const std::vector<double> x = m_rng.randGaussian(0, 0.2, st.range(0));
+  const std::vector<double> y = m_rng.randGaussian(0, 0.2, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t, w, x, y);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, PositionPdeManyPhotons)
+  ->Arg(10000)
+  ->Arg(100000)
+  ->Unit(benchmark::kMicrosecond);
+
+// All photons detected for each hit distribution, kCustomMap uses a gaussian
+// spot on a 16x16 map
+BENCHMARK_DEFINE_F(BenchmarkSensor, HitDistributionManyPhotons)(benchmark::State& st) {
+  auto prop = sipm::SiPMProperties();
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setHitDistribution(static_cast<sipm::SiPMProperties::HitDistribution>(st.range(1)));
+  if (prop.hitDistribution() == sipm::SiPMProperties::HitDistribution::kCustomMap) {
+    std::vector<double> map(16 * 16);
+    for (uint32_t i = 0; i < map.size(); ++i) {
+      const double r = i / 16 - 7.5;
+      const double c = i % 16 - 7.5;
+      map[i] = std::exp(-(r * r + c * c) / 18);
+    }
+    prop.setHitMap(map, 16, 16);
+  }
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(100, 10, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, HitDistributionManyPhotons)
+  ->ArgsProduct({{10000}, {0, 1, 2, 3}})
+  ->Unit(benchmark::kMicrosecond);
+
+// Many photons with low flat PDE selected one by one or with binomial thinning
+BENCHMARK_DEFINE_F(BenchmarkSensor, PdeSamplingManyPhotons)(benchmark::State& st) {
+  auto prop = sipm::SiPMProperties();
+  prop.setPde(0.01);
+  prop.setDcrOff();
+  prop.setPdeSampling(static_cast<sipm::SiPMProperties::PdeSampling>(st.range(1)));
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(100, 10, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, PdeSamplingManyPhotons)
+  ->ArgsProduct({{10000, 100000, 1000000}, {0, 1}})
+  ->Unit(benchmark::kMicrosecond);
+
+// Many photons with low PDE: cost is dominated by the PDE evaluation
+BENCHMARK_DEFINE_F(BenchmarkSensor, SpectrumPdeManyPhotons)(benchmark::State& st) {
+  auto prop = sipm::SiPMProperties();
+  const std::vector<double> wlen = {300, 400, 500, 600, 700};
+  const std::vector<double> pde = {0.001, 0.003, 0.002, 0.001, 0.0005};
+  prop.setPdeSpectrum(wlen, pde, st.range(1));
+  prop.setDcrOff();
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(100, 10, st.range(0));
+  const std::vector<double> w = m_rng.randGaussian(500, 100, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t, w);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, SpectrumPdeManyPhotons)
+  ->ArgsProduct({{1000, 10000, 100000}, {32, 256}})
+  ->Unit(benchmark::kMicrosecond);
+
 BENCHMARK_DEFINE_F(BenchmarkSensor, DefaultFullEvent)(benchmark::State& st) {
   m_sensor.setProperties(sipm::SiPMProperties());
 
@@ -107,4 +263,169 @@ BENCHMARK_DEFINE_F(BenchmarkSensor, DefaultFullEvent)(benchmark::State& st) {
   }
 }
 BENCHMARK_REGISTER_F(BenchmarkSensor, DefaultFullEvent)->RangeMultiplier(2)->Range(1, 1 << 12);
+BENCHMARK_DEFINE_F(BenchmarkSensor, DefaultBatchLightSim)(benchmark::State& st) {
+  static constexpr uint32_t nEvents = 64;
+  m_sensor.setProperties(sipm::SiPMProperties());
+  std::vector<double> times;
+  std::vector<uint32_t> offsets = {0};
+  for (uint32_t i = 0; i < nEvents; ++i) {
+    const std::vector<double> t = m_rng.randGaussian(10, 0.1, st.range(0));
+    times.insert(times.end(), t.begin(), t.end());
+    offsets.push_back(times.size());
+  }
+  std::vector<float> signals(nEvents * m_sensor.properties().nSignalPoints());
+  std::vector<sipm::SiPMDebugInfo> debugs(nEvents);
+  for (auto _ : st) {
+    m_sensor.runEvents(times, offsets, signals.data(), debugs.data());
+    benchmark::DoNotOptimize(signals.data());
+  }
+  st.SetItemsProcessed(st.iterations() * nEvents);
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, DefaultBatchLightSim)->RangeMultiplier(2)->Range(1, 1 << 12);
+
+// High occupancy: 6x6 mm sensor with 10 um pitch (360000 cells).
+// Second argument selects the recovery mode (0 per cell, 1 time sorted).
+BENCHMARK_DEFINE_F(BenchmarkSensor, HighOccupancyLightSim)(benchmark::State& st) {
+  sipm::SiPMProperties prop;
+  prop.setProperty("size", 6);
+  prop.setProperty("pitch", 10);
+  prop.setRecoveryMode(st.range(1) ? sipm::SiPMProperties::RecoveryMode::kTimeSorted
+                                   : sipm::SiPMProperties::RecoveryMode::kPerCell);
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(10, 0.1, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, HighOccupancyLightSim)
+  ->ArgsProduct({{1, 10, 100, 1000, 10000, 100000}, {0, 1}});
+
+// Same as above on default sensor (1x1 mm, 25 um pitch)
+BENCHMARK_DEFINE_F(BenchmarkSensor, RecoveryModeLightSim)(benchmark::State& st) {
+  sipm::SiPMProperties prop;
+  prop.setRecoveryMode(st.range(1) ? sipm::SiPMProperties::RecoveryMode::kTimeSorted
+                                   : sipm::SiPMProperties::RecoveryMode::kPerCell);
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(10, 0.1, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, RecoveryModeLightSim)
+  ->ArgsProduct({{1, 10, 100, 1000, 10000, 100000}, {0, 1}});
+
+// Signal synthesis engines. Second argument selects the engine (0 auto,
+// 1 direct, 2 recursive, 3 FFT). Photons are spread over the whole signal.
+BENCHMARK_DEFINE_F(BenchmarkSensor, SignalEngineLightSim)(benchmark::State& st) {
+  sipm::SiPMProperties prop;
+  prop.setProperty("size", 6);
+  prop.setSignalEngine(static_cast<sipm::SiPMProperties::SignalEngine>(st.range(1)));
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(100, 50, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, SignalEngineLightSim)
+  ->ArgsProduct({{1, 10, 100, 1000, 10000}, {0, 1, 2, 3}});
+
+// Same as above with a 20 us long signal
+BENCHMARK_DEFINE_F(BenchmarkSensor, SignalEngineLongSignal)(benchmark::State& st) {
+  sipm::SiPMProperties prop;
+  prop.setProperty("size", 6);
+  prop.setProperty("signallength", 20000);
+  prop.setSignalEngine(static_cast<sipm::SiPMProperties::SignalEngine>(st.range(1)));
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(10000, 5000, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, SignalEngineLongSignal)
+  ->ArgsProduct({{1, 10, 100, 1000, 10000}, {0, 1, 2, 3}})
+  ->Unit(benchmark::kMicrosecond);
+
+// Sub-nanosecond timing: analytic shape sampled at 10 ps (0) or 10 ps pulse
+// template with 1 ns output sampling (1)
+BENCHMARK_DEFINE_F(BenchmarkSensor, PulseTemplateLightSim)(benchmark::State& st) {
+  sipm::SiPMProperties prop;
+  if (st.range(1) == 0) {
+    prop.setSampling(0.01);
+  } else {
+    std::vector<double> pulse(50000);
+    for (uint32_t i = 0; i < pulse.size(); ++i) {
+      pulse[i] = std::exp(-i * 0.01 / prop.fallingTimeFast()) - std::exp(-i * 0.01 / prop.risingTime());
+    }
+    prop.setPulseTemplate(pulse, 0.01);
+  }
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(100, 10, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t);
+    m_sensor.runEvent();
+  }
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, PulseTemplateLightSim)
+  ->ArgsProduct({{1, 10, 100, 1000}, {0, 1}})
+  ->Unit(benchmark::kMicrosecond);
+
+// Direct signal engine with each backend of SiPMDispatch (0 scalar, 1 AVX2,
+// 2 AVX512)
+BENCHMARK_DEFINE_F(BenchmarkSensor, DispatchLightSim)(benchmark::State& st) {
+  const auto backend = static_cast<sipm::SiPMDispatch::Backend>(st.range(1));
+  if (!sipm::SiPMDispatch::setBackend(backend)) {
+    st.SkipWithError("Backend not supported");
+    return;
+  }
+  sipm::SiPMProperties prop;
+  prop.setProperty("size", 6);
+  prop.setSignalEngine(sipm::SiPMProperties::SignalEngine::kDirect);
+  m_sensor.setProperties(prop);
+  const std::vector<double> t = m_rng.randGaussian(100, 50, st.range(0));
+  for (auto _ : st) {
+    m_sensor.resetState();
+    m_sensor.addPhotons(t);
+    m_sensor.runEvent();
+  }
+  sipm::SiPMDispatch::setBackend(sipm::SiPMDispatch::bestBackend());
+}
+BENCHMARK_REGISTER_F(BenchmarkSensor, DispatchLightSim)->ArgsProduct({{10, 100, 1000}, {0, 1, 2}});
+
+// Scaling of multi-threaded batch simulation. Each benchmark simulates the same
+// batch using a different number of threads, items_per_second should increase
+// linearly with the number of threads.
+static void BatchRunnerLightSim(benchmark::State& st) {
+  static constexpr uint32_t nEvents = 4096;
+  sipm::SiPMRandom rng;
+  sipm::SiPMBatchRunner runner(sipm::SiPMProperties(), st.range(0));
+  std::vector<double> times;
+  std::vector<uint32_t> offsets = {0};
+  for (uint32_t i = 0; i < nEvents; ++i) {
+    const std::vector<double> t = rng.randGaussian(10, 0.1, 100);
+    times.insert(times.end(), t.begin(), t.end());
+    offsets.push_back(times.size());
+  }
+  std::vector<float> signals(nEvents * runner.properties().nSignalPoints());
+  std::vector<sipm::SiPMDebugInfo> debugs(nEvents);
+  for (auto _ : st) {
+    runner.runEvents(times, offsets, signals.data(), debugs.data());
+    benchmark::DoNotOptimize(signals.data());
+  }
+  st.SetItemsProcessed(st.iterations() * nEvents);
+}
+BENCHMARK(BatchRunnerLightSim)
+  ->RangeMultiplier(2)
+  ->Range(1, std::max(1u, std::thread::hardware_concurrency()))
+  ->UseRealTime()
+  ->Unit(benchmark::kMillisecond);
+
 BENCHMARK_MAIN();
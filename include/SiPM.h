@@ -3,9 +3,17 @@
 
 #define SIPM_VERSION "2.1.0"
 
+#include "SiPMAliasTable.h"
 #include "SiPMAnalogSignal.h"
+#include "SiPMAnalogSignalView.h"
+#include "SiPMBatchRunner.h"
 #include "SiPMDebugInfo.h"
+#include "SiPMDispatch.h"
+#include "SiPMEventContext.h"
+#include "SiPMFft.h"
 #include "SiPMHit.h"
+#include "SiPMMath.h"
+#include "SiPMModel.h"
 #include "SiPMProperties.h"
 #include "SiPMRandom.h"
 #include "SiPMSensor.h"
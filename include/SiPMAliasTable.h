@@ -0,0 +1,60 @@
+/** @class sipm::SiPMAliasTable SimSiPM/SimSiPM/SiPMAliasTable.h SiPMAliasTable.h
+ *
+ *  @brief Sampler of discrete distributions using the alias method
+ *
+ *  Walker's alias method with Vose's construction: the table is built once in
+ *  O(n) from a set of non-negative weights and each sample costs one uniform
+ *  integer, one uniform float and a comparison, independently of the number of
+ *  bins. Sampling does not modify the table, so a single table can be shared
+ *  among threads.
+ *
+ *  REFERENCE: M. D. Vose (1991): A linear algorithm for generating random
+ *             numbers with a given distribution, IEEE Transactions on Software
+ *             Engineering 17 (1991), 972-975.
+ *
+ *  @author Edoardo Proserpio
+ *  @date 2026
+ */
+
+#ifndef SIPM_SIPMALIASTABLE_H
+#define SIPM_SIPMALIASTABLE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "SiPMRandom.h"
+
+namespace sipm {
+class SiPMAliasTable {
+public:
+  /// @brief Builds the table for a distribution proportional to the weights
+  /** Weights do not need to be normalized. If all weights are 0 the
+   * distribution is uniform. */
+  explicit SiPMAliasTable(const std::vector<double>& weights);
+
+  SiPMAliasTable() = default;
+
+  /// @brief Returns the number of bins
+  uint32_t size() const { return m_Prob.size(); }
+
+  /// @brief Returns true if the table has no bins
+  bool empty() const { return m_Prob.empty(); }
+
+  /// @brief Returns a bin index with probability proportional to its weight
+  inline uint32_t sample(SiPMRandom& rng) const noexcept {
+    const uint32_t i = rng.randInteger(m_Prob.size());
+    return rng.Rand<float>() < m_Prob[i] ? i : m_Alias[i];
+  }
+
+  /// @brief Writes n bin indices in a user buffer
+  /** Random values are generated in bulk and the alias is selected without
+   * branches. */
+  void sample(SiPMRandom&, const uint32_t, uint32_t*) const noexcept;
+
+private:
+  // Probability of keeping the bin instead of taking its alias
+  std::vector<float> m_Prob;
+  std::vector<uint32_t> m_Alias;
+};
+} // namespace sipm
+#endif /* SIPM_SIPMALIASTABLE_H */
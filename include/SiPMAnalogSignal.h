@@ -23,8 +23,11 @@
 #include <cstdint>
 #include <iostream>
 #include <sstream>
+#include <utility>
 #include <vector>
 
+#include "SiPMAnalogSignalView.h"
+
 namespace sipm {
 class SiPMAnalogSignal {
 public:
@@ -35,6 +38,13 @@ public:
 
   float* data() noexcept { return m_Waveform.data(); }
 
+  /// @brief Sets number of points and sampling time reusing allocated memory
+  /** Values of the waveform are left unspecified. */
+  void resize(const uint32_t n, const double sampling) {
+    m_Waveform.resize(n);
+    m_Sampling = sampling;
+  }
+
   inline float& operator[](const uint32_t i) noexcept { return m_Waveform[i]; }
   inline float operator[](const uint32_t i) const noexcept { return m_Waveform[i]; }
 
@@ -43,9 +53,19 @@ public:
   /// @brief Returns the sampling time of the signal in ns
   inline double sampling() const { return m_Sampling; }
   /// @brief Returns the signal length in ns
-  inline double length() const { return (double)m_Waveform.size() / m_Sampling; }
+  inline double length() const { return view().length(); }
   /// @brief Returns the waveform in an accessible data structure
   inline const std::vector<float>& waveform() const noexcept {return m_Waveform; }
+  /// @brief Returns a non-owning view of the waveform
+  SiPMAnalogSignalView view() const noexcept { return {m_Waveform.data(), size(), m_Sampling}; }
+
+  /// @brief Moves the waveform out of the signal leaving it empty
+  /** Used to give back memory of a signal that is no longer needed. */
+  std::vector<float> releaseWaveform() noexcept {
+    std::vector<float> out = std::move(m_Waveform);
+    m_Waveform.clear();
+    return out;
+  }
 
 
   /// @brief Returns integral of the signal
@@ -68,7 +88,7 @@ public:
 
 private:
   std::vector<float> m_Waveform;
-  double m_Sampling;
+  double m_Sampling = 1;
 } /* SiPMAnalogSignal */;
 
 } /* namespace sipm */
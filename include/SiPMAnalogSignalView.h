@@ -0,0 +1,62 @@
+/** @class sipm::SiPMAnalogSignalView SimSiPM/SimSiPM/SiPMAnalogSignalView.h
+ * SiPMAnalogSignalView.h
+ *
+ *  @brief Non-owning view of a sampled waveform.
+ *
+ *  This class refers to a waveform stored elsewhere (e.g. the signal of a
+ *  @ref SiPMAnalogSignal or one event of the buffer filled by
+ *  @ref SiPMSensor::runEvents) and provides the same features of
+ *  @ref SiPMAnalogSignal without copying the samples.
+ *  The view is valid as long as the referred buffer is not modified or
+ *  destroyed, e.g. until the next event is simulated.
+ *
+ *  @author Edoardo Proserpio
+ *  @date 2026
+ */
+
+#ifndef SIPM_SIPMANALOGSIGNALVIEW_H
+#define SIPM_SIPMANALOGSIGNALVIEW_H
+
+#include <cstdint>
+
+namespace sipm {
+class SiPMAnalogSignalView {
+public:
+  SiPMAnalogSignalView() = default;
+
+  /// @brief Creates a view of n samples starting at data
+  SiPMAnalogSignalView(const float* data, const uint32_t n, const double sampling) noexcept
+    : m_Data(data), m_Size(n), m_Sampling(sampling) {}
+
+  const float* data() const noexcept { return m_Data; }
+  const float* begin() const noexcept { return m_Data; }
+  const float* end() const noexcept { return m_Data + m_Size; }
+
+  inline float operator[](const uint32_t i) const noexcept { return m_Data[i]; }
+
+  /// @brief Returns the number of points in the waveform
+  inline uint32_t size() const noexcept { return m_Size; }
+  /// @brief Returns the sampling time of the signal in ns
+  inline double sampling() const noexcept { return m_Sampling; }
+  /// @brief Returns the signal length in ns
+  inline double length() const noexcept { return m_Size * m_Sampling; }
+
+  /// @brief Returns integral of the signal
+  double integral(const double, const double, const double) const;
+  /// @brief Returns peak of the signal
+  double peak(const double, const double, const double) const;
+  /// @brief Returns time over threshold of the signal
+  double tot(const double, const double, const double) const;
+  /// @brief Returns time of arrival of the signal
+  double toa(const double, const double, const double) const;
+  /// @brief Returns time of peak
+  double top(const double, const double, const double) const;
+
+private:
+  const float* m_Data = nullptr;
+  uint32_t m_Size = 0;
+  double m_Sampling = 1;
+};
+
+} /* namespace sipm */
+#endif /* SIPM_SIPMANALOGSIGNALVIEW_H */
@@ -0,0 +1,104 @@
+/** @class sipm::SiPMBatchRunner SimSiPM/SimSiPM/SiPMBatchRunner.h SiPMBatchRunner.h
+ *
+ *  @brief Multi-threaded simulation of batches of events
+ *
+ *  This class splits a batch of events, stored using the same layout of
+ *  @ref SiPMSensor::runEvents, among many worker threads. All workers share
+ *  the same immutable @ref SiPMModel while each one owns its own
+ *  @ref SiPMEventContext, hence its own hits, buffers and random number
+ *  generator, and simulates a contiguous range of the batch writing the results
+ *  directly in the preallocated output buffers. Workers do not share any
+ *  mutable state so no lock is needed during the simulation.
+ *
+ *  @author Edoardo Proserpio
+ *  @date 2026
+ */
+
+#ifndef SIPM_SIPMBATCHRUNNER_H
+#define SIPM_SIPMBATCHRUNNER_H
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "SiPMDebugInfo.h"
+#include "SiPMEventContext.h"
+#include "SiPMModel.h"
+#include "SiPMProperties.h"
+#include "SiPMRandom.h"
+
+namespace sipm {
+class SiPMBatchRunner {
+public:
+  /// @brief SiPMBatchRunner constructor from a @ref SiPMProperties instance
+  /** Creates nThreads workers simulating a sensor described by the
+   * SiPMProperties. If nThreads is 0 the number of hardware threads is used.
+   */
+  explicit SiPMBatchRunner(const SiPMProperties&, const uint32_t nThreads = 0);
+
+  SiPMBatchRunner() : SiPMBatchRunner(SiPMProperties()) {}
+
+  /// @brief Returns the @ref SiPMProperties used by all workers
+  const SiPMProperties& properties() const { return m_Model.properties(); }
+
+  /// @brief Returns the @ref SiPMModel shared by all workers
+  const SiPMModel& model() const { return m_Model; }
+
+  /// @brief Returns the number of worker threads
+  uint32_t nThreads() const { return m_Contexts.size(); }
+
+  /// @brief Sets a different SiPMProperties for all workers
+  void setProperties(const SiPMProperties&);
+
+  /// @brief Sets the random engine used by all workers
+  /** With a counter-based engine (@ref SiPMRandom::Engine::kPhilox4x32) each
+   * event uses its own random stream, hence results are identical for any
+   * number of threads. The last seed given to @ref seed is kept, without one
+   * each worker uses a random seed. */
+  void setEngine(const SiPMRandom::Engine);
+
+  /// @brief Returns the id of the first event of the next batch
+  uint64_t eventId() const { return m_EventId; }
+
+  /// @brief Sets the id of the first event of the next batch
+  void setEventId(const uint64_t id) { m_EventId = id; }
+
+  /// @brief Seeds all workers
+  /** Worker i uses the i-th non-overlapping substream of a generator seeded
+   * with the given seed (@ref SiPMRandom::split), so results are reproducible
+   * for a given seed and number of threads. With a counter-based engine all
+   * workers use the same seed and streams are selected by event id. Event id
+   * is reset to 0.
+   */
+  void seed(const uint64_t);
+
+  /// @brief Runs a batch of events using all workers
+  /** @sa SiPMSensor::runEvents for the layout of input and output buffers.
+   * Events get consecutive ids starting from @ref eventId. */
+  void runEvents(const std::vector<double>&, const std::vector<uint32_t>&, float*, SiPMDebugInfo* = nullptr);
+
+  /// @brief Runs a batch of events considering photon wavelengths using all workers
+  void runEvents(const std::vector<double>&, const std::vector<double>&, const std::vector<uint32_t>&, float*,
+                 SiPMDebugInfo* = nullptr);
+
+  /// @brief Runs a batch of events using raw buffers
+  void runEvents(const double*, const double*, const uint32_t*, const uint32_t, float*, SiPMDebugInfo* = nullptr);
+
+  friend std::ostream& operator<<(std::ostream&, const SiPMBatchRunner&);
+  std::string toString() const {
+    std::stringstream ss;
+    ss << *this;
+    return ss.str();
+  }
+
+private:
+  SiPMModel m_Model;
+  std::vector<SiPMEventContext> m_Contexts;
+  uint64_t m_EventId = 0;
+  // Last seed given to seed(), reapplied when the engine changes
+  uint64_t m_Seed = 0;
+  bool m_Seeded = false;
+};
+} // namespace sipm
+#endif /* SIPM_SIPMBATCHRUNNER_H */
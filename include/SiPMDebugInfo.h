@@ -24,12 +24,17 @@ struct SiPMDebugInfo {
                           const uint32_t aDXt, const uint32_t aAp) noexcept
     : nPhotons(aPh), nPhotoelectrons(aPe), nDcr(aDcr), nXt(aXt), nDXt(aDXt), nAp(aAp) {}
 
-  const uint32_t nPhotons;        ///< Number of photons impinging on the sensor surface
-  const uint32_t nPhotoelectrons; ///< Number of photoelectrons: total number of hitted cells
-  const uint32_t nDcr;            ///< Number of DCR events generated
-  const uint32_t nXt;             ///< Number of XT events generated: XT and DXT
-  const uint32_t nDXt;            ///< Number of DXT events generated
-  const uint32_t nAp;             ///< Number of AP events generated
+  /** @brief Default constructor, all counters set to 0.
+   * Allows to preallocate arrays of SiPMDebugInfo (e.g. for @ref SiPMSensor::runEvents)
+   */
+  constexpr SiPMDebugInfo() noexcept = default;
+
+  uint32_t nPhotons = 0;        ///< Number of photons impinging on the sensor surface
+  uint32_t nPhotoelectrons = 0; ///< Number of photoelectrons: total number of hitted cells
+  uint32_t nDcr = 0;            ///< Number of DCR events generated
+  uint32_t nXt = 0;             ///< Number of XT events generated: XT and DXT
+  uint32_t nDXt = 0;            ///< Number of DXT events generated
+  uint32_t nAp = 0;             ///< Number of AP events generated
   friend std::ostream& operator<<(std::ostream&, const SiPMDebugInfo&);
   std::string toString() const {
     std::stringstream ss;
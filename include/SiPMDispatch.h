@@ -0,0 +1,67 @@
+/** @file SiPMDispatch.h SimSiPM/SimSiPM/SiPMDispatch.h SiPMDispatch.h
+ *
+ *  @brief Runtime selection of the instruction set used by hot loops
+ *
+ *  The library is built for the baseline instruction set of its target
+ *  (x86-64 for the PyPI wheels) but the kernels listed here are also compiled
+ *  for AVX2 and AVX512. When the library is loaded the CPU is inspected with
+ *  cpuid and the fastest supported backend is selected. The selection can be
+ *  queried and overridden, e.g. to compare backends or to reproduce results
+ *  bit by bit on different machines.
+ *
+ *  Random streams do not depend on the backend. Floating point results can
+ *  differ in the last bits because AVX2 and AVX512 kernels use FMA
+ *  instructions.
+ *
+ *  On other architectures only @ref Backend::kScalar is available.
+ *
+ *  @author Edoardo Proserpio
+ *  @date 2026
+ */
+
+#ifndef SIPM_SIPMDISPATCH_H
+#define SIPM_SIPMDISPATCH_H
+
+#include <cstdint>
+
+namespace sipm {
+namespace SiPMDispatch {
+/// @brief Instruction sets of kernels
+/** kScalar kernels are compiled for the baseline target of the build, which
+ * includes SSE2 on x86-64 and NEON on AArch64. */
+enum class Backend { kScalar, kAVX2, kAVX512 };
+
+/// @brief Returns the backend currently used by kernels
+Backend backend() noexcept;
+
+/// @brief Returns the fastest backend supported by this CPU
+Backend bestBackend() noexcept;
+
+/// @brief Returns true if this CPU and this build can use a backend
+bool isSupported(const Backend) noexcept;
+
+/// @brief Selects the backend used by kernels
+/** Returns false and keeps the current backend if the backend is not
+ * supported. It should be called when no simulation is running. */
+bool setBackend(const Backend) noexcept;
+
+/// @brief Returns the name of a backend
+const char* backendName(const Backend) noexcept;
+
+// Kernels used by the library, implemented for each backend
+
+/// @brief Advances 8 interleaved xoshiro256+ generators by n steps
+/** Writes 8 * n values in out, which needs no alignment. State is stored as
+ * state[word][lane]. */
+void xoshiro256plus(uint64_t (&state)[4][8], void* out, const uint32_t n) noexcept;
+
+/// @brief Philox4x32-10 of 16 consecutive counters
+/** Counters start from counter and differ in their first word. Output is
+ * stored as out[word][counter]. */
+void philox4x32(const uint32_t (&counter)[4], const uint32_t (&key)[2], uint32_t (&out)[4][16]) noexcept;
+
+/// @brief Computes y[i] += a * x[i] for n values
+void accumulate(float* __restrict__ y, const float* __restrict__ x, const float a, const uint32_t n) noexcept;
+} // namespace SiPMDispatch
+} // namespace sipm
+#endif /* SIPM_SIPMDISPATCH_H */
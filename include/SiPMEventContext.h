@@ -0,0 +1,259 @@
+/** @class sipm::SiPMEventContext SimSiPM/SimSiPM/SiPMEventContext.h SiPMEventContext.h
+ *
+ *  @brief Mutable state of a SiPM event
+ *
+ *  This class stores everything that changes from one event to the other:
+ *  input photons, generated hits, MC-Truth counters, output signal and the
+ *  random number generator. It is simulated by a @ref SiPMModel, which only
+ *  stores immutable data, so many contexts (e.g. one per thread) can be
+ *  simulated using the same model without any synchronization.
+ *
+ *  Buffers keep their capacity between events so that, after a few events,
+ *  the simulation does not need to allocate memory.
+ *
+ *  @author Edoardo Proserpio
+ *  @date 2026
+ */
+
+#ifndef SIPM_SIPMEVENTCONTEXT_H
+#define SIPM_SIPMEVENTCONTEXT_H
+
+#include <complex>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "SiPMAnalogSignal.h"
+#include "SiPMAnalogSignalView.h"
+#include "SiPMDebugInfo.h"
+#include "SiPMHit.h"
+#include "SiPMRandom.h"
+
+namespace sipm {
+class SiPMEventContext {
+public:
+  SiPMEventContext() = default;
+
+  /// @brief Creates a context with a seeded random number generator
+  explicit SiPMEventContext(const uint64_t aseed) { m_rng.seed(aseed); }
+
+  /// @brief Creates a context with a seeded random number generator using the given engine
+  SiPMEventContext(const uint64_t aseed, const SiPMRandom::Engine engine) : m_rng(engine) { m_rng.seed(aseed); }
+
+  /// @brief Returns the id of the next event simulated with this context
+  /** The id is incremented after each event. With a counter-based
+   * @ref SiPMRandom engine the random stream of each event only depends on
+   * seed, event id and channel id. */
+  uint64_t eventId() const { return m_EventId; }
+
+  /// @brief Sets the id of the next event simulated with this context
+  /** Can be used to simulate again a single event of a larger run. */
+  void setEventId(const uint64_t id) { m_EventId = id; }
+
+  /// @brief Returns the channel id used to select the random stream
+  uint32_t channelId() const { return m_ChannelId; }
+
+  /// @brief Sets the channel id used to select the random stream
+  void setChannelId(const uint32_t id) { m_ChannelId = id; }
+
+  /// @brief Returns the @ref SiPMAnalogSignal of the last simulated event
+  const SiPMAnalogSignal& signal() const { return m_Signal; }
+
+  /// @brief Returns a non-owning view of the signal of the last simulated event
+  SiPMAnalogSignalView signalView() const { return m_Signal.view(); }
+
+  /// @brief Moves the signal of the last simulated event out of the context
+  /** The context keeps simulating in a buffer taken from the pool of signals
+   * given back with @ref recycleSignal, so a loop that takes each signal and
+   * recycles it when done does not allocate memory. */
+  SiPMAnalogSignal takeSignal() {
+    SiPMAnalogSignal out = std::move(m_Signal);
+    if (m_SignalPool.empty()) {
+      m_Signal = SiPMAnalogSignal();
+    } else {
+      m_Signal = SiPMAnalogSignal(std::move(m_SignalPool.back()), out.sampling());
+      m_SignalPool.pop_back();
+    }
+    return out;
+  }
+
+  /// @brief Gives back a signal obtained with @ref takeSignal to reuse its memory
+  void recycleSignal(SiPMAnalogSignal&& signal) {
+    // Signal taken without a replacement is replaced now
+    if (m_Signal.waveform().capacity() == 0) {
+      m_Signal = std::move(signal);
+    } else {
+      m_SignalPool.push_back(signal.releaseWaveform());
+    }
+  }
+
+  /// @brief Returns the @ref SiPMHitStore containing all hits
+  const SiPMHitStore& hits() const { return m_Hits; }
+
+  /// @brief Returns the index of the parent hit of each hit
+  const std::vector<int32_t>& hitsGraph() const { return m_Hits.parents(); }
+
+  /// @brief Returns a @ref SiPMDebugInfo struct with MC-Truth values
+  SiPMDebugInfo debug() const {
+    return SiPMDebugInfo{static_cast<uint32_t>(m_PhotonTimes.size()), m_nPe, m_nDcr, m_nXt, m_nDXt, m_nAp};
+  }
+
+  /// @brief Returns the @ref SiPMRandom rng used for this context
+  SiPMRandom& rng() { return m_rng; }
+  const SiPMRandom& rng() const { return m_rng; }
+
+  /// @brief Adds a single photon to the list of photons to be simulated
+  void addPhoton(const double time) { m_PhotonTimes.emplace_back(time); }
+
+  /// @brief Adds a single photon to the list of photons to be simulated
+  void addPhoton(const double time, const double wavelength) {
+    m_PhotonTimes.emplace_back(time);
+    m_PhotonWavelengths.emplace_back(wavelength);
+  }
+
+  /// @brief Adds multiple photons to the list of photons to be simulated at once
+  void addPhotons(const std::vector<double>& times) { addPhotons(times.data(), nullptr, times.size()); }
+
+  /// @brief Adds multiple photons to the list of photons to be simulated at once
+  void addPhotons(const std::vector<double>& times, const std::vector<double>& wavelengths) {
+    addPhotons(times.data(), wavelengths.data(), times.size());
+  }
+
+  /// @brief Sets n photons from raw buffers (not appending). Wavelengths can be null.
+  void addPhotons(const double* times, const double* wavelengths, const uint32_t n) {
+    m_PhotonTimes.assign(times, times + n);
+    if (wavelengths) {
+      m_PhotonWavelengths.assign(wavelengths, wavelengths + n);
+    } else {
+      m_PhotonWavelengths.clear();
+    }
+    m_PhotonX.clear();
+    m_PhotonY.clear();
+  }
+
+  /// @brief Adds a single photon hitting the sensor in position (x, y)
+  /** Positions are in mm with the origin in the center of the sensor, x
+   * runs along the columns of cells and y along the rows. Positions are only
+   * used if they are given for all the photons of the event. */
+  void addPhoton(const double time, const double wavelength, const double x, const double y) {
+    addPhoton(time, wavelength);
+    m_PhotonX.emplace_back(x);
+    m_PhotonY.emplace_back(y);
+  }
+
+  /// @brief Adds multiple photons with their positions at once @sa addPhoton
+  void addPhotons(const std::vector<double>& times, const std::vector<double>& wavelengths,
+                  const std::vector<double>& x, const std::vector<double>& y) {
+    addPhotons(times.data(), wavelengths.empty() ? nullptr : wavelengths.data(), x.data(), y.data(), times.size());
+  }
+
+  /// @brief Sets n photons with their positions from raw buffers (not appending) @sa addPhoton
+  /** Wavelengths can be null. Photons outside of the sensor are not detected. */
+  void addPhotons(const double* times, const double* wavelengths, const double* x, const double* y,
+                  const uint32_t n) {
+    addPhotons(times, wavelengths, n);
+    m_PhotonX.assign(x, x + n);
+    m_PhotonY.assign(y, y + n);
+  }
+
+  /// @brief Single precision version of @ref addPhotons with positions
+  void addPhotons(const float* times, const float* wavelengths, const float* x, const float* y, const uint32_t n) {
+    m_PhotonTimes.assign(times, times + n);
+    if (wavelengths) {
+      m_PhotonWavelengths.assign(wavelengths, wavelengths + n);
+    } else {
+      m_PhotonWavelengths.clear();
+    }
+    m_PhotonX.assign(x, x + n);
+    m_PhotonY.assign(y, y + n);
+  }
+
+  /// @brief Returns true if positions are given for all photons
+  bool hasPhotonPositions() const { return !m_PhotonTimes.empty() && m_PhotonX.size() == m_PhotonTimes.size(); }
+
+  /// @brief Resets the context to a fresh state
+  /** Resets counters, hits and photons so the context can be used for a new
+   * event. Memory is not released. */
+  void resetState() {
+    m_nTotalHits = 0;
+    m_nPe = 0;
+    m_nDcr = 0;
+    m_nXt = 0;
+    m_nDXt = 0;
+    m_nAp = 0;
+    m_Hits.clear();
+    m_PhotonTimes.clear();
+    m_PhotonWavelengths.clear();
+    m_PhotonX.clear();
+    m_PhotonY.clear();
+  }
+
+private:
+  friend class SiPMModel;
+
+  SiPMRandom m_rng;
+  uint64_t m_EventId = 0;
+  uint32_t m_ChannelId = 0;
+
+  uint32_t m_nTotalHits = 0;
+  uint32_t m_nPe = 0;
+  uint32_t m_nDcr = 0;
+  uint32_t m_nXt = 0;
+  uint32_t m_nDXt = 0;
+  uint32_t m_nAp = 0;
+
+  std::vector<double> m_PhotonTimes;
+  std::vector<double> m_PhotonWavelengths;
+  // Positions of photons in mm, stored in single precision for the
+  // quantization kernel
+  std::vector<float> m_PhotonX;
+  std::vector<float> m_PhotonY;
+  // Photoelectrons generation: PDE of each photon, indices of accepted
+  // photons, uniforms used for PDE and cells hitted (cells of each photon
+  // when positions are given)
+  std::vector<double> m_PdeValues;
+  std::vector<uint32_t> m_AcceptedPhotons;
+  std::vector<float> m_Uniforms;
+  std::vector<uint64_t> m_SelectedMask;
+  std::vector<uint32_t> m_CellRows;
+  std::vector<uint32_t> m_CellCols;
+  // Times of hits generated in bulk
+  std::vector<double> m_HitTimes;
+  // Correlated noise: uniforms and parent of each child of a generation
+  std::vector<double> m_CascadeUniforms;
+  std::vector<uint32_t> m_XtParents;
+  std::vector<uint32_t> m_ApParents;
+  // Mean and then value of each delay of a generation, and its truncation
+  std::vector<double> m_Delays;
+  std::vector<double> m_DelayMax;
+  // Relative gain of each hit given by ccgv
+  std::vector<float> m_Gains;
+  SiPMHitStore m_Hits;
+
+  SiPMAnalogSignal m_Signal;
+  // Buffers given back with recycleSignal
+  std::vector<std::vector<float>> m_SignalPool;
+
+  // Scratch buffers used to find hits in the same cell. A cell is occupied
+  // in current event only if its stamp is equal to m_Generation, so the
+  // dense per-cell arrays never need to be cleared.
+  uint32_t m_Generation = 0;
+  std::vector<uint32_t> m_CellStamp;
+  std::vector<uint32_t> m_CellHead;
+  std::vector<uint32_t> m_NextHit;
+  std::vector<uint32_t> m_OccupiedCells;
+  std::vector<uint32_t> m_CellHits;
+  // Scratch buffers used for time sorted recovery
+  std::vector<double> m_CellLastTime;
+  std::vector<uint32_t> m_SortKeys;
+  std::vector<uint32_t> m_SortedHits;
+  std::vector<uint32_t> m_SortTmpKeys;
+  std::vector<uint32_t> m_SortTmpHits;
+  // Impulse trains used by recursive signal engine
+  std::vector<double> m_Impulses;
+  // Buffers used by FFT signal engine
+  std::vector<double> m_FftBuffer;
+  std::vector<std::complex<double>> m_FftSpectrum;
+};
+} // namespace sipm
+#endif /* SIPM_SIPMEVENTCONTEXT_H */
@@ -0,0 +1,67 @@
+/** @class sipm::SiPMFft SimSiPM/SimSiPM/SiPMFft.h SiPMFft.h
+ *
+ *  @brief Real Fast Fourier Transform of fixed size
+ *
+ *  Minimal self-contained real FFT used to convolve signals. A SiPMFft object
+ *  is a plan for a given size: twiddle factors and bit-reversal permutation
+ *  are computed once in the constructor and transforms do not allocate
+ *  memory, so a single plan can be shared among threads.
+ *
+ *  A real sequence of size N (power of 2) is transformed using a complex
+ *  radix-2 FFT of size N/2 on even/odd samples packed as real/imaginary parts.
+ *
+ *  @author Edoardo Proserpio
+ *  @date 2026
+ */
+
+#ifndef SIPM_SIPMFFT_H
+#define SIPM_SIPMFFT_H
+
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+namespace sipm {
+class SiPMFft {
+public:
+  /// @brief Creates a plan for real sequences of size n (power of 2, at least 2)
+  explicit SiPMFft(const uint32_t n);
+
+  SiPMFft() = default;
+
+  /// @brief Returns the size of real sequences
+  uint32_t size() const { return m_N; }
+
+  /// @brief Returns the number of complex bins of the spectrum (n / 2 + 1)
+  uint32_t nBins() const { return m_N / 2 + 1; }
+
+  /// @brief Forward transform of n real values into n / 2 + 1 complex bins
+  void forward(const double*, std::complex<double>*) const noexcept;
+
+  /// @brief Inverse transform of n / 2 + 1 complex bins into n real values
+  /** Result is scaled so that forward followed by inverse gives the input. */
+  void inverse(const std::complex<double>*, double*) const noexcept;
+
+  /// @brief Returns the smallest power of 2 greater or equal than n
+  static uint32_t nextPow2(const uint32_t n) {
+    uint32_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+private:
+  // In-place complex FFT of size m_N / 2. Inverse is not scaled.
+  void complexFft(std::complex<double>*, const bool) const noexcept;
+
+  uint32_t m_N = 0;
+  // Twiddles of the complex FFT exp(-2 pi i k / (N / 2)), k < N / 4
+  std::vector<std::complex<double>> m_Twiddles;
+  // Twiddles used to split the packed spectrum exp(-2 pi i k / N), k <= N / 2
+  std::vector<std::complex<double>> m_SplitTwiddles;
+  // Bit reversal permutation of size N / 2
+  std::vector<uint32_t> m_BitReverse;
+};
+} // namespace sipm
+#endif /* SIPM_SIPMFFT_H */
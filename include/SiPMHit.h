@@ -13,11 +13,14 @@
 #ifndef SIPM_SIPMHITS_H
 #define SIPM_SIPMHITS_H
 
+#include <cstddef>
 #include <cstdint>
 #include <iomanip>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 namespace sipm {
 class SiPMHit {
@@ -34,9 +37,12 @@ public:
     kSlowAfterPulse           ///< Hit generated by a slow afterpulse
   };
 
+  /// @brief Value used as parent index for hits without a parent
+  static constexpr int32_t kNoParent = -1;
+
   constexpr SiPMHit(double time, float amp, uint32_t row, uint32_t col, HitType type,
-                    const SiPMHit* parentPtr = nullptr) noexcept
-    : m_Time(time), m_Amplitude(amp), m_Row(row), m_Col(col), m_HitType(type), m_ParentPtr(parentPtr) {}
+                    int32_t parent = kNoParent) noexcept
+    : m_Time(time), m_Parent(parent), m_Amplitude(amp), m_Row(row), m_Col(col), m_HitType(type) {}
 
 
   /// @brief Comparison operator for hits
@@ -69,7 +75,8 @@ public:
   float& amplitude() { return m_Amplitude; }
   /// @brief Returns hit type to identify the hits
   constexpr HitType hitType() const noexcept { return m_HitType; }
-  constexpr const SiPMHit* parent() const noexcept { return m_ParentPtr; }
+  /// @brief Returns index of the hit that generated this one or @ref kNoParent
+  constexpr int32_t parent() const noexcept { return m_Parent; }
 
   friend std::ostream& operator<<(std::ostream&, const SiPMHit&);
   std::string toString() const {
@@ -85,7 +92,7 @@ private:
   // Once a hit is constructed only
   // amplitude can be changed
   const double m_Time;
-  const SiPMHit* m_ParentPtr;
+  const int32_t m_Parent;
   float m_Amplitude;
   const uint32_t m_Row;
   const uint32_t m_Col;
@@ -122,5 +129,152 @@ inline std::ostream& operator<<(std::ostream& out, const SiPMHit& obj) {
   }
   return out;
 }
+
+/** @class sipm::SiPMHitStore
+ *
+ * @brief Structure-of-arrays storage for all the hits of an event.
+ *
+ * Each property of the hits is stored in its own contiguous column so that the
+ * signal generation can stream over times and amplitudes without chasing
+ * pointers. Columns keep their capacity when the store is cleared, hence after
+ * a few events no further allocation is needed.
+ * Hits are identified by their index in the store, which is also used to link
+ * a correlated noise hit to its parent.
+ */
+class SiPMHitStore {
+public:
+  /// @brief Returns number of hits stored
+  uint32_t size() const noexcept { return m_Time.size(); }
+  /// @brief Returns true if no hit is stored
+  bool empty() const noexcept { return m_Time.empty(); }
+
+  /// @brief Removes all hits keeping the allocated memory
+  void clear() noexcept {
+    m_Time.clear();
+    m_Amplitude.clear();
+    m_Row.clear();
+    m_Col.clear();
+    m_HitType.clear();
+    m_Parent.clear();
+  }
+
+  /// @brief Reserves memory for at least n hits
+  void reserve(const uint32_t n) {
+    m_Time.reserve(n);
+    m_Amplitude.reserve(n);
+    m_Row.reserve(n);
+    m_Col.reserve(n);
+    m_HitType.reserve(n);
+    m_Parent.reserve(n);
+  }
+
+  /// @brief Adds a new hit and returns its index
+  uint32_t add(const double time, const float amp, const uint32_t row, const uint32_t col,
+               const SiPMHit::HitType type, const int32_t parent = SiPMHit::kNoParent) {
+    m_Time.push_back(time);
+    m_Amplitude.push_back(amp);
+    m_Row.push_back(row);
+    m_Col.push_back(col);
+    m_HitType.push_back(type);
+    m_Parent.push_back(parent);
+    return m_Time.size() - 1;
+  }
+
+  /// @brief Adds n hits with amplitude 1 and no parent, returns index of the first one
+  /** Times and cells are copied from the given buffers. */
+  uint32_t add(const uint32_t n, const double* times, const uint32_t* rows, const uint32_t* cols,
+               const SiPMHit::HitType type) {
+    const uint32_t first = m_Time.size();
+    m_Time.insert(m_Time.end(), times, times + n);
+    m_Amplitude.resize(first + n, 1);
+    m_Row.insert(m_Row.end(), rows, rows + n);
+    m_Col.insert(m_Col.end(), cols, cols + n);
+    m_HitType.resize(first + n, type);
+    m_Parent.resize(first + n, SiPMHit::kNoParent);
+    return first;
+  }
+
+  /// @brief Returns a copy of the i-th hit
+  SiPMHit operator[](const uint32_t i) const noexcept {
+    return SiPMHit{m_Time[i], m_Amplitude[i], m_Row[i], m_Col[i], m_HitType[i], m_Parent[i]};
+  }
+
+  /// @brief Access a single property of the i-th hit
+  double time(const uint32_t i) const noexcept { return m_Time[i]; }
+  float amplitude(const uint32_t i) const noexcept { return m_Amplitude[i]; }
+  float& amplitude(const uint32_t i) noexcept { return m_Amplitude[i]; }
+  uint32_t row(const uint32_t i) const noexcept { return m_Row[i]; }
+  uint32_t col(const uint32_t i) const noexcept { return m_Col[i]; }
+  SiPMHit::HitType hitType(const uint32_t i) const noexcept { return m_HitType[i]; }
+  int32_t parent(const uint32_t i) const noexcept { return m_Parent[i]; }
+
+  /// @brief Column with time of each hit in ns
+  const std::vector<double>& times() const noexcept { return m_Time; }
+  /// @brief Column with relative amplitude of each hit
+  const std::vector<float>& amplitudes() const noexcept { return m_Amplitude; }
+  std::vector<float>& amplitudes() noexcept { return m_Amplitude; }
+  /// @brief Column with row of each hitted cell
+  const std::vector<uint32_t>& rows() const noexcept { return m_Row; }
+  /// @brief Column with column of each hitted cell
+  const std::vector<uint32_t>& cols() const noexcept { return m_Col; }
+  /// @brief Column with type of each hit
+  const std::vector<SiPMHit::HitType>& hitTypes() const noexcept { return m_HitType; }
+  /// @brief Column with parent index of each hit (@ref SiPMHit::kNoParent if none)
+  const std::vector<int32_t>& parents() const noexcept { return m_Parent; }
+
+  /// @brief Iterator over the hits of the store
+  /** Hits are built on the fly from the columns, so iterating does not copy
+   * the store or allocate memory. */
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = SiPMHit;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = SiPMHit;
+
+    const_iterator(const SiPMHitStore* store, const uint32_t i) noexcept : m_Store(store), m_Index(i) {}
+    SiPMHit operator*() const noexcept { return (*m_Store)[m_Index]; }
+    const_iterator& operator++() noexcept {
+      ++m_Index;
+      return *this;
+    }
+    const_iterator operator++(int) noexcept {
+      const_iterator out = *this;
+      ++m_Index;
+      return out;
+    }
+    bool operator==(const const_iterator& rhs) const noexcept { return m_Index == rhs.m_Index; }
+    bool operator!=(const const_iterator& rhs) const noexcept { return m_Index != rhs.m_Index; }
+    /// @brief Index of the hit in the store
+    uint32_t index() const noexcept { return m_Index; }
+
+  private:
+    const SiPMHitStore* m_Store;
+    uint32_t m_Index;
+  };
+
+  /// @brief Range of all hits, e.g. for (const SiPMHit hit : store)
+  const_iterator begin() const noexcept { return {this, 0}; }
+  const_iterator end() const noexcept { return {this, size()}; }
+
+  /// @brief Returns all hits as a vector of @ref SiPMHit
+  std::vector<SiPMHit> toVector() const {
+    std::vector<SiPMHit> out;
+    out.reserve(size());
+    for (uint32_t i = 0; i < size(); ++i) {
+      out.push_back(operator[](i));
+    }
+    return out;
+  }
+
+private:
+  std::vector<double> m_Time;
+  std::vector<float> m_Amplitude;
+  std::vector<uint32_t> m_Row;
+  std::vector<uint32_t> m_Col;
+  std::vector<SiPMHit::HitType> m_HitType;
+  std::vector<int32_t> m_Parent;
+};
 } // namespace sipm
 #endif /* SIPM_SIPMHITS_H */
@@ -0,0 +1,61 @@
+/** @file SiPMMath.h SimSiPM/SimSiPM/SiPMMath.h SiPMMath.h
+ *
+ *  @brief Vectorized approximations of elementary functions
+ *
+ *  Functions in this namespace apply log, exp or sincos to arrays of values.
+ *  They are used by the bulk samplers of @ref sipm::SiPMRandom so that their
+ *  throughput does not depend on the compiler vectorizing calls to libm.
+ *
+ *  Kernels are written once using vector extensions of GCC and Clang and are
+ *  compiled for the target of the build (128 bits vectors with SSE2 or NEON,
+ *  wider when AVX2 or AVX512 are enabled). On x86 they are also compiled for
+ *  AVX2 and AVX512 and the version matching @ref sipm::SiPMDispatch::backend
+ *  is used, the build target is used with the scalar backend. Results can
+ *  differ in the last bit depending on the availability of FMA instructions.
+ *
+ *  Float versions use the polynomials of the Cephes library, double versions
+ *  those of fdlibm. Errors are given with respect to the correctly rounded
+ *  result and are checked in tests/math.cpp. Inputs must be finite and
+ *  output arrays can be the same as input arrays.
+ *
+ *  @author Edoardo Proserpio
+ *  @date 2026
+ */
+
+#ifndef SIPM_SIPMMATH_H
+#define SIPM_SIPMMATH_H
+
+#include <cstdint>
+
+namespace sipm {
+namespace SiPMMath {
+/// @brief Natural logarithm of n floats
+/** Inputs must be positive normal numbers. Maximum error is 1 ulp. */
+void log(const float*, const uint32_t, float*) noexcept;
+
+/// @brief Exponential of n floats
+/** Inputs are clamped to [-87, 88], the range of normal results.
+ * Maximum error is 1 ulp. */
+void exp(const float*, const uint32_t, float*) noexcept;
+
+/// @brief Sine and cosine of n floats
+/** Maximum absolute error is 1e-7 for inputs in [-8192, 8192]. Argument
+ * reduction loses precision for larger inputs. */
+void sincos(const float*, const uint32_t, float*, float*) noexcept;
+
+/// @brief Natural logarithm of n doubles
+/** Inputs must be positive normal numbers. Maximum error is 1 ulp. */
+void log(const double*, const uint32_t, double*) noexcept;
+
+/// @brief Exponential of n doubles
+/** Inputs are clamped to [-708, 709], the range of normal results.
+ * Maximum error is 1.5 ulp. */
+void exp(const double*, const uint32_t, double*) noexcept;
+
+/// @brief Sine and cosine of n doubles
+/** Maximum absolute error is 2e-16 for inputs in [-1e6, 1e6]. Argument
+ * reduction loses precision for larger inputs. */
+void sincos(const double*, const uint32_t, double*, double*) noexcept;
+} // namespace SiPMMath
+} // namespace sipm
+#endif /* SIPM_SIPMMATH_H */
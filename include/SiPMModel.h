@@ -0,0 +1,135 @@
+/** @class sipm::SiPMModel SimSiPM/SimSiPM/SiPMModel.h SiPMModel.h
+ *
+ *  @brief Immutable description of a SiPM used to simulate events
+ *
+ *  This class stores the @ref SiPMProperties of a sensor along with all the
+ *  quantities that can be precomputed from them (e.g. the signal shape).
+ *  A model is never modified by the simulation: all the per-event state is
+ *  stored in a @ref SiPMEventContext passed to the simulation methods. Hence a
+ *  single model can be shared among many threads, each one simulating its own
+ *  context.
+ *
+ *  @author Edoardo Proserpio
+ *  @date 2026
+ */
+
+#ifndef SIPM_SIPMMODEL_H
+#define SIPM_SIPMMODEL_H
+
+#include <complex>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "SiPMAliasTable.h"
+#include "SiPMDebugInfo.h"
+#include "SiPMEventContext.h"
+#include "SiPMFft.h"
+#include "SiPMProperties.h"
+#include "SiPMRandom.h"
+#include "SiPMTypes.h"
+
+namespace sipm {
+class SiPMModel {
+public:
+  /// @brief SiPMModel constructor from a @ref SiPMProperties instance
+  explicit SiPMModel(const SiPMProperties&);
+
+  SiPMModel();
+
+  /// @brief Returns the @ref SiPMProperties of the model
+  const SiPMProperties& properties() const { return m_Properties; }
+
+  /// @brief Returns the shape of the signal generated by a single photoelectron
+  const std::vector<float>& signalShape() const { return m_SignalShape; }
+
+  /// @brief Simulates an event using photons stored in the context
+  /** Signal and hits are stored in the context and its event id is
+   * incremented. */
+  void runEvent(SiPMEventContext&) const;
+
+  /// @brief Simulates a batch of events @sa SiPMSensor::runEvents
+  /** Events get consecutive ids starting from the event id of the context. */
+  void runEvents(SiPMEventContext&, const double*, const double*, const uint32_t*, const uint32_t, float*,
+                 SiPMDebugInfo* = nullptr) const;
+
+  friend std::ostream& operator<<(std::ostream&, const SiPMModel&);
+  std::string toString() const {
+    std::stringstream ss;
+    ss << *this;
+    return ss.str();
+  }
+
+private:
+  void pdeTable();
+  void hitMapTable();
+  void correlatedNoiseTables();
+  double evaluatePde(const double) const;
+  void evaluatePde(const double*, const uint32_t, double*) const noexcept;
+  pair<uint32_t> hitUniform(SiPMRandom&) const;
+  pair<uint32_t> hitMap(SiPMRandom&) const;
+  pair<uint32_t> hitGaussian(SiPMRandom&) const;
+  pair<uint32_t> hitCell(SiPMRandom&) const;
+  void hitCells(SiPMRandom&, const uint32_t, uint32_t*, uint32_t*) const;
+  void positionCells(const float*, const float*, const uint32_t*, const uint32_t, uint32_t*, uint32_t*) const noexcept;
+  void signalShape();
+  void pulseTemplateBank();
+  void noiseBank();
+
+  void beginEvent(SiPMEventContext&) const;
+  void generateNoise(SiPMEventContext&, float*) const;
+  void runEvent(SiPMEventContext&, float*) const;
+  void addDcrEvents(SiPMEventContext&) const;
+  void addPhotoelectrons(SiPMEventContext&) const;
+  void addCorrelatedNoise(SiPMEventContext&) const;
+
+  uint32_t nextGeneration(SiPMEventContext&) const;
+  void calculateSignalAmplitudes(SiPMEventContext&) const;
+  void recoveryPerCell(SiPMEventContext&) const;
+  void recoveryTimeSorted(SiPMEventContext&) const;
+  void generateSignal(SiPMEventContext&, float*) const;
+  void generateSignalDirect(const SiPMEventContext&, float*) const;
+  void generateSignalRecursive(SiPMEventContext&, float*) const;
+  void generateSignalFft(SiPMEventContext&, float*) const;
+  void generateSignalPolyphase(const SiPMEventContext&, float*) const;
+
+  SiPMProperties m_Properties;
+  // PDE spectrum on a uniform grid: bin i covers wavelengths starting at
+  // m_PdeMin + i / m_PdeRecStep and PDE = slope * wavelength + intercept
+  double m_PdeMin = 0;
+  double m_PdeRecStep = 0;
+  std::vector<double> m_PdeSlope;
+  std::vector<double> m_PdeIntercept;
+  // Probability of each cell to be hit by a photon, used by
+  // HitDistribution::kCircle and HitDistribution::kCustomMap
+  SiPMAliasTable m_HitTable;
+  std::vector<float> m_SignalShape;
+  // Signal shape as sum of exponentials: weight and decay rate (1/samples)
+  std::vector<double> m_PulseWeights;
+  std::vector<double> m_PulseRates;
+  // Pulse template shifted by a fraction of sample, one row of nSignalPoints
+  // values for each phase
+  std::vector<float> m_PulsePhases;
+
+  // CDF of the number of crosstalk and afterpulse hits generated by a hit
+  std::vector<double> m_XtCdf;
+  std::vector<double> m_ApCdf;
+
+  // Relative cost of FFT engine with respect to direct engine, measured with
+  // SignalEngineLightSim benchmark
+  static constexpr double kFftCost = 8;
+  SiPMFft m_Fft;
+  // Spectrum of signal shape padded to FFT size
+  std::vector<std::complex<double>> m_ShapeSpectrum;
+  // Minimum number of hits for which kAuto uses FFT engine
+  double m_FftMinHits = 0;
+
+  static constexpr uint64_t kNoiseBankSeed = 0x5349504d4e4f4953;
+  // Ring buffer of noise used with NoiseMode::kBank. First nSignalPoints
+  // values are repeated at the end so windows can be copied without wrapping
+  std::vector<float> m_NoiseBank;
+  uint32_t m_NoiseBankSize = 0;
+};
+} // namespace sipm
+#endif /* SIPM_SIPMMODEL_H */
@@ -14,6 +14,7 @@
 #ifndef SIPM_SIPMPROPERTIES_H
 #define SIPM_SIPMPROPERTIES_H
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <iostream>
@@ -33,25 +34,67 @@ public:
     kSimplePde,  ///< Same PDE value used for all photons
     kSpectrumPde ///< PDE calculated considering the wavelength of each photon
   };
+  /** @enum PdeSampling
+   * Used to select how photons are selected with PdeType::kSimplePde. Both
+   * give the same distribution of detected photons.
+   */
+  enum class PdeSampling {
+    kPerPhoton, ///< One uniform random value is compared with the PDE for each photon
+    kBinomial   ///< Number of detected photons is sampled from a binomial distribution and then the detected photons
+                ///< are selected at random. Uses about min(nDetected, nPhotons - nDetected) random values
+  };
   /** @enum HitDistribution
    * Used to describe how photoelectrons are distributed on the SiPM surface
    */
   enum class HitDistribution {
     kUniform, ///< Photons uniformly distributed on the sensor surface
-    kCircle,  ///< 95% of photons are uniformly distributed on a circle
-    kGaussian ///< 95% of photons have a gaussian distribution
+    kCircle,   ///< 90% of photons are uniformly distributed on a circle
+    kGaussian, ///< 95% of photons have a gaussian distribution
+    kCustomMap ///< Photons follow a user defined intensity map, see @ref setHitMap
+  };
+  /** @enum RecoveryMode
+   * Used to select the algorithm applying cell recovery to hits in the same
+   * cell. Both give the same amplitudes. kTimeSorted is faster when many
+   * hits share the same cells (small sensors or large pitch) while kPerCell is
+   * faster when most cells have a single hit.
+   */
+  enum class RecoveryMode {
+    kPerCell,   ///< Hits are grouped by cell and each group is sorted by time
+    kTimeSorted ///< All hits are radix sorted by time once and processed in a single sweep
+  };
+  /** @enum SignalEngine
+   * Used to select the algorithm used to build the signal from the hits.
+   */
+  enum class SignalEngine {
+    kAuto,      ///< kDirect or kFft, whichever is expected to be faster for each event
+    kDirect,    ///< Signal shape is added for each hit. Hit times are truncated to the sampling time
+    kRecursive, ///< Hits are placed in an impulse train filtered by one recursive filter for each exponential
+                ///< component of the signal. Cost does not depend on hits*points and sub-sample timing is exact
+    kFft        ///< Hits are histogrammed in time bins and convolved with the signal shape using FFT. Same
+                ///< results of kDirect
+  };
+  /** @enum NoiseMode
+   * Used to select how the electronic noise baseline is generated.
+   */
+  enum class NoiseMode {
+    kGenerated, ///< Independent gaussian values are generated for each event
+    kBank       ///< A window starting at a random offset is copied from a precomputed ring buffer of noise. Windows of
+                ///< different events can overlap, see @ref setNoiseMode
   };
 
   SiPMProperties();
 
+  /// @brief Default number of points used to resample the PDE spectrum
+  static constexpr uint32_t kPdeSpectrumPoints = 32;
+
   /// @brief Used to read settings from a json file
   static SiPMProperties readSettings(const std::string&);
 
   /// @brief Returns size of sensor in mm
-  constexpr uint32_t size() const { return m_Size; }
+  constexpr double size() const { return m_Size; }
 
   /// @brief Returns pitch of cell in um
-  constexpr uint32_t pitch() const { return m_Pitch; }
+  constexpr double pitch() const { return m_Pitch; }
 
   /// @brief Returns total number of cells in the sensor
   constexpr uint32_t nCells() const { return m_Ncells; }
@@ -65,6 +108,30 @@ public:
   /// @brief Returns @ref HitDistribution type of the sensor
   constexpr HitDistribution hitDistribution() const { return m_HitDistribution; }
 
+  /// @brief Returns intensity map used with HitDistribution::kCustomMap
+  const std::vector<double>& hitMap() const { return m_HitMap; }
+
+  /// @brief Returns number of rows of the intensity map
+  constexpr uint32_t hitMapRows() const { return m_HitMapRows; }
+
+  /// @brief Returns number of columns of the intensity map
+  constexpr uint32_t hitMapCols() const { return m_HitMapCols; }
+
+  /// @brief Returns @ref RecoveryMode used to compute cell recovery
+  constexpr RecoveryMode recoveryMode() const { return m_RecoveryMode; }
+
+  /// @brief Returns @ref SignalEngine used to build the signal
+  constexpr SignalEngine signalEngine() const { return m_SignalEngine; }
+
+  /// @brief Returns @ref NoiseMode used for the electronic noise
+  constexpr NoiseMode noiseMode() const { return m_NoiseMode; }
+
+  /// @brief Returns number of samples in the noise bank
+  constexpr uint32_t noiseBankSize() const { return m_NoiseBankSize; }
+
+  /// @brief Returns frequency-power values of the noise if set
+  const std::map<double, double>& noiseSpectrum() const { return m_NoiseSpectrum; }
+
   /// @brief Returns total signal length in ns
   constexpr double signalLength() const { return m_SignalLength; }
 
@@ -130,9 +197,33 @@ public:
   /// @brief Returns wavelength-PDE values if PdeType::kSpectrumPde is set
   const std::map<double, double>& pdeSpectrum() const { return m_PdeSpectrum; }
 
+  /// @brief Returns measured single photoelectron pulse if set @sa setPulseTemplate
+  const std::vector<double>& pulseTemplate() const { return m_PulseTemplate; }
+
+  /// @brief Returns sampling time of the pulse template in ns
+  constexpr double pulseTemplateSampling() const { return m_PulseTemplateSampling; }
+
+  /// @brief Returns number of sub-sample phases used with the pulse template
+  /** If not set the number of phases is sampling() / pulseTemplateSampling() */
+  uint32_t pulsePhases() const {
+    if (m_PulsePhases > 0) {
+      return m_PulsePhases;
+    }
+    if (m_PulseTemplateSampling <= 0) {
+      return 1;
+    }
+    return std::max<uint32_t>(1, std::lround(m_Sampling / m_PulseTemplateSampling));
+  }
+
+  /// @brief Returns true if a measured pulse template is used instead of the analytic signal shape
+  bool hasPulseTemplate() const { return !m_PulseTemplate.empty(); }
+
   /// @brief Returns type of PDE calculation used.
   constexpr PdeType pdeType() const { return m_HasPde; }
 
+  /// @brief Returns @ref PdeSampling used with PdeType::kSimplePde
+  constexpr PdeSampling pdeSampling() const { return m_PdeSampling; }
+
   /// @brief Returns true if DCR is considered.
   constexpr bool hasDcr() const { return m_HasDcr; }
 
@@ -292,13 +383,94 @@ public:
   constexpr void setSlowComponentOn() { m_HasSlowComponent = true; }
   /// @brief Sets a different type of PDE simulation @ref PdeType
   constexpr void setPdeType(PdeType val) { m_HasPde = val; }
+
+  /// @brief Set how photons are selected with PdeType::kSimplePde @ref PdeSampling
+  /** PdeSampling::kBinomial is faster for low PDE values and many photons per
+   * event. */
+  constexpr void setPdeSampling(const PdeSampling val) { m_PdeSampling = val; }
   /// @brief Set a spectral response of the SiPM and sets @ref
   /// PdeType::kSpectrumPde
-  void setPdeSpectrum(const std::vector<double>&, const std::vector<double>&);
+  /** The spectrum is resampled on 32 equally spaced wavelengths */
+  void setPdeSpectrum(const std::vector<double>& wav, const std::vector<double>& pde) {
+    setPdeSpectrum(wav, pde, kPdeSpectrumPoints);
+  }
+  /// @brief Set a spectral response of the SiPM resampled on n equally spaced wavelengths
+  void setPdeSpectrum(const std::vector<double>&, const std::vector<double>&, const uint32_t);
+
+  /// @brief Set a measured single photoelectron pulse used as signal shape
+  /** The template replaces the analytic signal shape. It is normalized to
+   * its peak and scaled by the gain. It can be sampled much finer than the
+   * signal: a bank of copies shifted by a fraction of the sampling time is
+   * precomputed and each hit uses the copy closest to its exact time.
+   * @param shape Pulse values starting at the photoelectron time
+   * @param sampling Sampling time of the template in ns
+   */
+  void setPulseTemplate(const std::vector<double>& shape, const double sampling) {
+    m_PulseTemplate = shape;
+    m_PulseTemplateSampling = sampling;
+  }
+
+  /// @brief Removes the pulse template and goes back to the analytic signal shape
+  void clearPulseTemplate() {
+    m_PulseTemplate.clear();
+    m_PulseTemplateSampling = 0;
+  }
+
+  /// @brief Set number of sub-sample phases used with the pulse template
+  /// @param val Number of phases, 0 to derive it from the template sampling
+  constexpr void setPulsePhases(const uint32_t val) { m_PulsePhases = val; }
+
+  /// @brief Set how the electronic noise is generated @ref NoiseMode
+  /** With NoiseMode::kBank the gaussian noise is generated once for a ring
+   * buffer of noiseBankSize() samples (rounded up to a power of 2) and each
+   * event copies a window of the signal length from a random offset. This is
+   * much faster than generating the noise for each event but the baselines
+   * are not independent: the bank only contains noiseBankSize() different
+   * windows and two events share some samples with probability close to
+   * 2 * nSignalPoints / noiseBankSize(). The bank is the same for all sensors
+   * with the same properties.
+   */
+  constexpr void setNoiseMode(const NoiseMode val) { m_NoiseMode = val; }
+
+  /// @brief Set number of samples in the noise bank
+  constexpr void setNoiseBankSize(const uint32_t val) { m_NoiseBankSize = val; }
+
+  /// @brief Set the power spectrum of the electronic noise and sets @ref NoiseMode::kBank
+  /** Values are linearly interpolated and only the shape of the spectrum is
+   * used, the noise RMS is always given by the SNR.
+   * @param freq Frequencies in GHz
+   * @param power Power spectral density in arbitrary units
+   */
+  void setNoiseSpectrum(const std::vector<double>& freq, const std::vector<double>& power) {
+    m_NoiseSpectrum.clear();
+    for (uint32_t i = 0; i < freq.size(); ++i) {
+      m_NoiseSpectrum[freq[i]] = power[i];
+    }
+    m_NoiseMode = NoiseMode::kBank;
+  }
 
   /// @brief Set hit distriution type
   constexpr void setHitDistribution(const HitDistribution val) { m_HitDistribution = val; }
 
+  /// @brief Set the light intensity map and sets @ref HitDistribution::kCustomMap
+  /** The map is a grid of nRows x nCols bins covering the whole sensor, with
+   * rows along the cell rows. Each cell takes the intensity of the bin
+   * containing its center, so the map does not need to match the number of
+   * cells. Intensities do not need to be normalized. A map with no bins or
+   * with a size different from nRows x nCols is rejected and
+   * @ref HitDistribution::kUniform is set instead.
+   * @param map Intensities in row-major order
+   * @param nRows Number of rows of the map
+   * @param nCols Number of columns of the map
+   */
+  void setHitMap(const std::vector<double>& map, const uint32_t nRows, const uint32_t nCols);
+
+  /// @brief Set algorithm used to compute cell recovery @ref RecoveryMode
+  constexpr void setRecoveryMode(const RecoveryMode val) { m_RecoveryMode = val; }
+
+  /// @brief Set algorithm used to build the signal @ref SignalEngine
+  constexpr void setSignalEngine(const SignalEngine val) { m_SignalEngine = val; }
+
   friend std::ostream& operator<<(std::ostream&, const SiPMProperties&);
   std::string toString() const {
     std::stringstream ss;
@@ -312,15 +484,23 @@ private:
   uint32_t m_Ncells;
   uint32_t m_SideCells;
   HitDistribution m_HitDistribution = HitDistribution::kUniform;
+  std::vector<double> m_HitMap;
+  uint32_t m_HitMapRows = 0;
+  uint32_t m_HitMapCols = 0;
 
   double m_Sampling = 1;
   double m_SignalLength = 500;
+  SignalEngine m_SignalEngine = SignalEngine::kAuto;
   uint32_t m_SignalPoints = 0;
   double m_RiseTime = 1;
   double m_FallTimeFast = 50;
   double m_FallTimeSlow = 100;
   double m_SlowComponentFraction = 0.2;
   double m_RecoveryTime = 50;
+  std::vector<double> m_PulseTemplate;
+  double m_PulseTemplateSampling = 0;
+  uint32_t m_PulsePhases = 0;
+  RecoveryMode m_RecoveryMode = RecoveryMode::kPerCell;
 
   double m_Dcr = 200e3;
   double m_Xt = 0.05;
@@ -334,10 +514,14 @@ private:
   double m_SnrdB = 30;
   float m_Gain = 1.0;
   double m_SnrLinear;
+  NoiseMode m_NoiseMode = NoiseMode::kGenerated;
+  uint32_t m_NoiseBankSize = 1 << 20;
+  std::map<double, double> m_NoiseSpectrum;
 
   double m_Pde = 1;
   std::map<double, double> m_PdeSpectrum;
   PdeType m_HasPde = PdeType::kNoPde;
+  PdeSampling m_PdeSampling = PdeSampling::kPerPhoton;
 
   bool m_HasDcr = true;
   bool m_HasXt = true;
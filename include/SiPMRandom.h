@@ -16,15 +16,13 @@
 #include <array>
 #include <cstddef>
 #include <cstdlib>
-#ifdef __AVX512F__
-#include <immintrin.h>
-#endif
 
 #include <cmath>
 #include <cstdint>
 #include <cstring>
 #include <vector>
 
+#include "SiPMDispatch.h"
 #include "SiPMTypes.h"
 
 // Musl implementation of lcg64
@@ -47,7 +45,13 @@ namespace SiPMRng {
  *
  * The state must be seeded so that it is not everywhere zero. If you have
  * a 64-bit seed, we suggest to seed a splitmix64 generator and use its
- * output to fill s. */
+ * output to fill s.
+ *
+ * Values are taken in turn from 8 interleaved generators seeded from the same
+ * seed, so that blocks can be generated with SIMD instructions. Generators
+ * start 2^192 steps apart, each one a long jump after the previous one. Blocks are
+ * generated by @ref SiPMDispatch::xoshiro256plus, the stream is the same for
+ * every backend. */
 class Xorshift256plus {
 public:
   /// @brief Default contructor for Xorshift256plus
@@ -67,18 +71,40 @@ public:
   /// @brief Manually set a seed
   void seed(const uint64_t);
 
+  /// @brief Advances the generator by 2^128 steps
+  /** Each of the interleaved generators is advanced by 2^128 steps, it can be
+   * used to generate 2^64 non-overlapping subsequences for parallel
+   * computations before reaching the start of the next interleaved generator.
+   * Values already generated in the internal buffer are discarded. */
+  void jump() noexcept;
+
+  /// @brief Advances the generator by 8 * 2^192 steps
+  /** Each of the interleaved generators is advanced past the start of all the
+   * others, it can be used to generate 2^61 starting points, from each one of
+   * them @ref jump will generate 2^64 non-overlapping subsequences for
+   * parallel distributed computations. */
+  void long_jump() noexcept;
+
+  /// @brief Returns the k-th non-overlapping substream of this generator
+  /** The returned generator is a copy of this one advanced by k jumps
+   * (k * 2^128 steps), hence split(0) continues this same stream and
+   * split(i), split(j) with i != j and both less than 2^64 never overlap for
+   * less than 2^128 draws from each interleaved generator.
+   * Cost is linear in k but no warm-up is needed. */
+  Xorshift256plus split(const uint64_t k) const;
+
 private:
-  // Generator state
-  alignas(64) uint64_t s[4];
+  // Number of interleaved generators
+  static constexpr uint32_t L = 8;
+  // Generator state, s[word][generator]
+  alignas(64) uint64_t s[4][L];
   // Size of the buffer
   static constexpr uint32_t N = 1 << 16;
   // Buffer for random values
   alignas(64) uint64_t buffer[N];
   uint32_t index = N;
-#ifdef __AVX512F__
-  // Generator state for AVX512
-  __m512i __s[4];
-#endif
+  // Applies a jump polynomial to all states
+  void applyJump(const uint64_t*) noexcept;
 
 public:
   /// @brief Returns a pseud-random 64-bits integer
@@ -90,145 +116,223 @@ public:
     return buffer[index++];
   }
 
-#ifdef __AVX512F__
-  // Overload for uint64_t
-  inline void getRand(uint64_t* __restrict array, const uint32_t n) noexcept {
-    size_t i = 0;
-    // Generate 8 uint64_t values per iteration
-    for (; i + 8 <= n; i += 8) {
-      const __m512i __result = _mm512_add_epi64(__s[0], __s[3]);
-      _mm512_store_si512(array + i, __result);
+  /// @brief Fills an array with n pseudo-random 64-bits integers
+  /** Values of a partially used step of the 8 generators are discarded. */
+  void getRand(uint64_t* __restrict array, const uint32_t n) noexcept;
 
-      const __m512i __t = _mm512_slli_epi64(__s[1], 17);
+  /// @brief Fills an array with n pseudo-random 32-bits integers
+  /** Each 64-bits value gives two values, lower bits first. */
+  void getRand(uint32_t* __restrict array, const uint32_t n) noexcept;
+};
 
-      __s[2] = _mm512_xor_epi64(__s[2], __s[0]);
-      __s[3] = _mm512_xor_epi64(__s[3], __s[1]);
-      __s[1] = _mm512_xor_epi64(__s[1], __s[2]);
-      __s[0] = _mm512_xor_epi64(__s[0], __s[3]);
+/// @brief Implementation of Philox4x32-10 counter-based PRNG algorithm
+/** Philox is a counter-based generator (Salmon et al., "Parallel random
+ * numbers: as easy as 1, 2, 3", SC11): each block of four 32-bit values is a
+ * bijection of a 128-bit counter under a 64-bit key, so any position of any
+ * stream can be computed directly without generating the previous values.
+ *
+ * The key is the seed while the counter is made of the block index, a channel
+ * id and an event id: (seed, eventId, channelId) identifies a stream of
+ * 2^33 64-bit values that does not depend on what has been generated before.
+ * Blocks are generated in groups of 16 counters by
+ * @ref SiPMDispatch::philox4x32. */
+class Philox4x32 {
+public:
+  /// @brief Default constructor for Philox4x32
+  /// It creates an instance of Philox4x32 using a random key from the system
+  /// random device
+  Philox4x32() { seed(); }
 
-      __s[2] = _mm512_xor_si512(__s[2], __t);
+  /// @brief Constructor with seed for Philox4x32
+  explicit Philox4x32(const uint64_t sd) { seed(sd); }
 
-      __s[3] = _mm512_rol_epi64(__s[3], 45);
-    }
-    // Handle leftover if n is not a multiple of 8
-    if (i < n) {
-      alignas(64) uint64_t buffer[8];
-      const __m512i __result = _mm512_add_epi64(__s[0], __s[3]);
-      _mm512_store_si512(buffer, __result);
+  /// @brief Sets a random seed generated using system random device.
+  void seed();
 
-      const __m512i __t = _mm512_slli_epi64(__s[1], 17);
+  /// @brief Sets the key of the generator and rewinds the current stream
+  void seed(const uint64_t sd) noexcept {
+    m_Key[0] = static_cast<uint32_t>(sd);
+    m_Key[1] = static_cast<uint32_t>(sd >> 32);
+    setStream(0, 0);
+  }
 
-      __s[2] = _mm512_xor_si512(__s[2], __s[0]);
-      __s[3] = _mm512_xor_si512(__s[3], __s[1]);
-      __s[1] = _mm512_xor_si512(__s[1], __s[2]);
-      __s[0] = _mm512_xor_si512(__s[0], __s[3]);
+  /// @brief Selects the stream identified by an event id and a channel id
+  /** Generation restarts from the first value of the stream. */
+  void setStream(const uint64_t eventId, const uint32_t channelId) noexcept {
+    m_Counter[0] = 0;
+    m_Counter[1] = channelId;
+    m_Counter[2] = static_cast<uint32_t>(eventId);
+    m_Counter[3] = static_cast<uint32_t>(eventId >> 32);
+    index = N;
+  }
 
-      __s[2] = _mm512_xor_si512(__s[2], __t);
+  /// @brief Returns a copy using a different key
+  /** Streams generated with different keys are statistically independent,
+   * the k-th substream uses the key seed + k. */
+  Philox4x32 split(const uint64_t k) const noexcept {
+    Philox4x32 other(*this);
+    const uint64_t key = ((static_cast<uint64_t>(m_Key[1]) << 32) | m_Key[0]) + k;
+    other.m_Key[0] = static_cast<uint32_t>(key);
+    other.m_Key[1] = static_cast<uint32_t>(key >> 32);
+    other.index = N;
+    return other;
+  }
 
-      __s[3] = _mm512_rol_epi64(__s[3], 45);
-      for (size_t j = 0; j < n - i; ++j) {
-        array[i + j] = buffer[j];
-      }
+  /// @brief Returns the Philox4x32-10 bijection of a counter under a key
+  static std::array<uint32_t, 4> block(const std::array<uint32_t, 4>& ctr, const std::array<uint32_t, 2>& key) noexcept {
+    uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int r = 0; r < 10; ++r) {
+      const uint64_t p0 = static_cast<uint64_t>(M0) * c0;
+      const uint64_t p1 = static_cast<uint64_t>(M1) * c2;
+      c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+      c1 = static_cast<uint32_t>(p1);
+      c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+      c3 = static_cast<uint32_t>(p0);
+      k0 += W0;
+      k1 += W1;
     }
+    return {c0, c1, c2, c3};
   }
 
-  // Overload for uint32_t
-  inline void getRand(uint32_t* array, const uint32_t n) noexcept {
-    size_t i = 0;
-
-    // Generate 8 uint64_t values per iteration and split them into 16 uint32_t values
-    for (; i + 16 <= n; i += 16) {
-      const __m512i __result = _mm512_add_epi64(__s[0], __s[3]);
-
-      _mm512_store_si512(array + i, __result);
-
-      const __m512i __t = _mm512_slli_epi64(__s[1], 17);
-
-      __s[2] = _mm512_xor_si512(__s[2], __s[0]);
-      __s[3] = _mm512_xor_si512(__s[3], __s[1]);
-      __s[1] = _mm512_xor_si512(__s[1], __s[2]);
-      __s[0] = _mm512_xor_si512(__s[0], __s[3]);
+private:
+  static constexpr uint32_t M0 = 0xD2511F53;
+  static constexpr uint32_t M1 = 0xCD9E8D57;
+  static constexpr uint32_t W0 = 0x9E3779B9;
+  static constexpr uint32_t W1 = 0xBB67AE85;
+  // Number of counters processed together by SiPMDispatch::philox4x32
+  static constexpr uint32_t W = 16;
+  // Size of the buffer: one group of blocks, as the stream is usually
+  // changed every event
+  static constexpr uint32_t N = 2 * W;
+
+  uint32_t m_Key[2];
+  // Block index, channel id, event id (low and high)
+  uint32_t m_Counter[4];
+  alignas(64) uint64_t buffer[N];
+  uint32_t index = N;
 
-      __s[2] = _mm512_xor_si512(__s[2], __t);
+  // Generates W consecutive blocks (2 * W uint64_t values) in lane-major order
+  inline void generateBlocks(uint32_t (&out)[4][W]) noexcept {
+    SiPMDispatch::philox4x32(m_Counter, m_Key, out);
+    m_Counter[0] += W;
+  }
 
-      __s[3] = _mm512_rol_epi64(__s[3], 45);
+public:
+  /// @brief Returns a pseudo-random 64-bits integer
+  inline uint64_t operator()() noexcept {
+    if (index == N) {
+      getRand(buffer, N);
+      index = 0;
     }
+    return buffer[index++];
+  }
 
-    // Handle leftover if n is not a multiple of 16
-    if (i < n) {
-      alignas(64) uint32_t buffer[16];
-      const __m512i __result = _mm512_add_epi64(__s[0], __s[3]);
-      _mm512_store_si512(buffer, __result);
-
-      const __m512i __t = _mm512_slli_epi64(__s[1], 17);
-
-      __s[2] = _mm512_xor_si512(__s[2], __s[0]);
-      __s[3] = _mm512_xor_si512(__s[3], __s[1]);
-      __s[1] = _mm512_xor_si512(__s[1], __s[2]);
-      __s[0] = _mm512_xor_si512(__s[0], __s[3]);
-
-      __s[2] = _mm512_xor_si512(__s[2], __t);
-
-      __s[3] = _mm512_rol_epi64(__s[3], 45);
-
-      // Fill the remaining uint32_t values
-      for (size_t j = 0; j < n - i; ++j) {
-        array[i + j] = buffer[j];
+  /// @brief Fills an array with n pseudo-random 64-bits integers
+  /** Each block gives two values, (c1 << 32 | c0) and (c3 << 32 | c2).
+   * Values of a partially used group of blocks are discarded. */
+  inline void getRand(uint64_t* __restrict array, const uint32_t n) noexcept {
+    uint32_t out[4][W];
+    uint32_t i = 0;
+    for (; i + 2 * W <= n; i += 2 * W) {
+      generateBlocks(out);
+      for (uint32_t l = 0; l < W; ++l) {
+        array[i + 2 * l] = (static_cast<uint64_t>(out[1][l]) << 32) | out[0][l];
+        array[i + 2 * l + 1] = (static_cast<uint64_t>(out[3][l]) << 32) | out[2][l];
       }
     }
-  }
-#else
-
-  // Overload for uint64_t (most of the times this one is used)
-  inline void getRand(uint64_t* __restrict array, const uint32_t n) {
-    for (uint32_t i = 0; i < n; ++i) {
-      const uint64_t randVal = s[0] + s[3];
-      const uint64_t t = s[1] << 17;
-      s[2] ^= s[0];
-      s[3] ^= s[1];
-      s[1] ^= s[2];
-      s[0] ^= s[3];
-
-      s[2] ^= t;
-      s[3] = (s[3] << 45) | (s[3] >> (64 - 45));
-
-      array[i] = randVal;
+    if (i < n) {
+      generateBlocks(out);
+      for (uint32_t j = 0; i + j < n; ++j) {
+        const uint32_t l = j / 2;
+        array[i + j] = (j & 1) ? (static_cast<uint64_t>(out[3][l]) << 32) | out[2][l]
+                               : (static_cast<uint64_t>(out[1][l]) << 32) | out[0][l];
+      }
     }
   }
 
-  // Overload for uint32_t
-  inline void getRand(uint32_t* __restrict array, const uint32_t n) {
-    for (uint32_t i = 0; i < n; i += 2) {
-      const uint64_t randVal = s[0] + s[3];
-      const uint64_t t = s[1] << 17;
-      s[2] ^= s[0];
-      s[3] ^= s[1];
-      s[1] ^= s[2];
-      s[0] ^= s[3];
-
-      s[2] ^= t;
-      s[3] = (s[3] << 45) | (s[3] >> (64 - 45));
-
-      array[i] = static_cast<uint32_t>(randVal); // Lower 32 bits
-      if (i + 1 < n) {
-        array[i + 1] = static_cast<uint32_t>(randVal >> 32); // Upper 32 bits
+  /// @brief Fills an array with n pseudo-random 32-bits integers
+  inline void getRand(uint32_t* __restrict array, const uint32_t n) noexcept {
+    uint32_t out[4][W];
+    uint32_t i = 0;
+    for (; i + 4 * W <= n; i += 4 * W) {
+      generateBlocks(out);
+      for (uint32_t l = 0; l < W; ++l) {
+        array[i + 4 * l] = out[0][l];
+        array[i + 4 * l + 1] = out[1][l];
+        array[i + 4 * l + 2] = out[2][l];
+        array[i + 4 * l + 3] = out[3][l];
+      }
+    }
+    if (i < n) {
+      generateBlocks(out);
+      for (uint32_t j = 0; i + j < n; ++j) {
+        array[i + j] = out[j % 4][j / 4];
       }
     }
   }
-#endif
 };
 } // namespace SiPMRng
 
 class SiPMRandom {
 public:
+  /// @brief Algorithm used to generate random bits
+  /** kXorshift256plus is the fastest for a single stream. kPhilox4x32 is a
+   * counter-based generator: each (seed, eventId, channelId) triplet selected
+   * with @ref setStream is a different stream, so results do not depend on
+   * how events are distributed among threads or nodes. */
+  enum class Engine { kXorshift256plus, kPhilox4x32 };
+
   SiPMRandom() = default;
 
+  /// @brief Creates a SiPMRandom using the selected engine
+  explicit SiPMRandom(const Engine engine) : m_Engine(engine) {}
+
+  /// @brief Returns the engine used to generate random bits
+  Engine engine() const { return m_Engine; }
+
+  /// @brief Returns true if the engine is counter-based
+  bool isCounterBased() const { return m_Engine == Engine::kPhilox4x32; }
+
   /// @brief Get a reference to the underlying PRNG */
   /// Use this method to seed the PRNG and to get the status
   SiPMRng::Xorshift256plus& rng() { return m_rng; }
 
+  /// @brief Get a reference to the underlying counter-based PRNG
+  SiPMRng::Philox4x32& philox() { return m_Philox; }
+
   // Seed underlying rng
-  void seed(const uint64_t x) { m_rng.seed(x); }
+  void seed(const uint64_t x) {
+    if (m_Engine == Engine::kPhilox4x32) {
+      m_Philox.seed(x);
+    } else {
+      m_rng.seed(x);
+    }
+  }
+
+  /// @brief Selects the stream of an event for the counter-based engine
+  /** Has no effect if the engine is not counter-based. */
+  void setStream(const uint64_t eventId, const uint32_t channelId = 0) noexcept {
+    if (m_Engine == Engine::kPhilox4x32) {
+      m_Philox.setStream(eventId, channelId);
+    }
+  }
+
+  /// @brief Advances the underlying PRNG by 2^128 steps @sa SiPMRng::Xorshift256plus::jump
+  void jump() noexcept { m_rng.jump(); }
+
+  /// @brief Returns a copy using the k-th non-overlapping substream @sa SiPMRng::Xorshift256plus::split
+  /** For the counter-based engine the k-th substream uses a different key
+   * @sa SiPMRng::Philox4x32::split */
+  SiPMRandom split(const uint64_t k) const {
+    SiPMRandom other(*this);
+    if (m_Engine == Engine::kPhilox4x32) {
+      other.m_Philox = m_Philox.split(k);
+    } else {
+      other.m_rng = m_rng.split(k);
+    }
+    return other;
+  }
 
   /// @brief Gives an uniformly distributed random
   template <typename T = double>
@@ -246,26 +350,68 @@ public:
   double randExponential(const double) noexcept;
   /// @brief Gives random float with exponential distribution
   float randExponentialF(const float) noexcept;
+  /// @brief Gives random double with exponential distribution truncated in [0, max]
+  double randExponentialTrunc(const double, const double) noexcept;
   /// @brief Gives random value with poisson distribution
   uint32_t randPoisson(const double mu) noexcept;
+  /// @brief Gives random value with binomial distribution
+  uint32_t randBinomial(const uint32_t n, const double p) noexcept;
+  /// @brief Selects k out of n elements uniformly without replacement
+  void randSubset(const uint32_t n, const uint32_t k, uint64_t* mask) noexcept;
 
   /// @brief Vector version of @ref Rand()
   std::vector<double> Rand(const uint32_t);
+  /// @brief Version of @ref Rand() writing n values in a user buffer
+  void Rand(const uint32_t, double*) noexcept;
   /// @brief Vector version of @ref RandF()
   std::vector<float> RandF(const uint32_t);
+  /// @brief Version of @ref RandF() writing n values in a user buffer
+  void RandF(const uint32_t, float*) noexcept;
   /// @brief Vector version of @ref randGaussian()
   std::vector<double> randGaussian(const double, const double, const uint32_t);
   /// @brief Vector version of @ref randGaussianF()
   std::vector<float> randGaussianF(const float, const float, const uint32_t);
+  /// @brief Version of @ref randGaussianF() writing n values in a user buffer
+  void randGaussianF(const float, const float, const uint32_t, float*) noexcept;
   /// @brief Vector version of @ref randInteger()
   std::vector<uint32_t> randInteger(const uint32_t max, const uint32_t n);
+  /// @brief Version of @ref randInteger() writing n values in a user buffer
+  void randInteger(const uint32_t max, const uint32_t n, uint32_t*) noexcept;
   /// @brief Vector version of @ref randExponential()
   std::vector<double> randExponential(const double, const uint32_t);
   /// @brief Vector version of @ref randExponentialF()
   std::vector<float> randExponentialF(const float, const uint32_t);
+  /// @brief Version of @ref randExponentialF() writing n values in a user buffer
+  void randExponentialF(const float, const uint32_t, float*) noexcept;
+  /// @brief Vector version of @ref randExponentialTrunc()
+  std::vector<double> randExponentialTrunc(const double, const double, const uint32_t);
+  /// @brief Version of @ref randExponentialTrunc() with a mean and a truncation for each value
+  void randExponentialTrunc(const double*, const double*, const uint32_t, double*) noexcept;
 
 private:
+  // Ziggurat samplers of the standard gaussian and exponential distributions
+  double standardGaussian() noexcept;
+  double standardExponential() noexcept;
+  // Complete samples of a layer not accepted by the fast test of the ziggurat
+  double gaussianSlow(const uint32_t, const double) noexcept;
+  double exponentialSlow(const uint32_t, const double) noexcept;
+
+  // Returns 64 random bits from the selected engine
+  inline uint64_t next() noexcept { return m_Engine == Engine::kPhilox4x32 ? m_Philox() : m_rng(); }
+
+  // Fills a buffer with random bits from the selected engine
+  template <typename T>
+  inline void fill(T* array, const uint32_t n) noexcept {
+    if (m_Engine == Engine::kPhilox4x32) {
+      m_Philox.getRand(array, n);
+    } else {
+      m_rng.getRand(array, n);
+    }
+  }
+
+  Engine m_Engine = Engine::kXorshift256plus;
   SiPMRng::Xorshift256plus m_rng;
+  SiPMRng::Philox4x32 m_Philox;
 };
 
 /**
@@ -276,7 +422,7 @@ private:
  */
 template <>
 inline double SiPMRandom::Rand<double>() noexcept {
-  return (m_rng() >> 11) * 0x1p-53;
+  return (next() >> 11) * 0x1p-53;
 }
 
 /**
@@ -287,7 +433,7 @@ inline double SiPMRandom::Rand<double>() noexcept {
  */
 template <>
 inline float SiPMRandom::Rand<float>() noexcept {
-  return (m_rng() >> 40) * 0x1p-24f;
+  return (next() >> 40) * 0x1p-24f;
 }
 } // namespace sipm
 #endif /* SIPM_RANDOM_H */
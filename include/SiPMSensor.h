@@ -2,7 +2,9 @@
  *
  *  @brief Main class used to simulate a SiPM
  *
- *  This class provides all the methods to simulate a SiPM sensor.
+ *  This class provides all the methods to simulate a SiPM sensor. It couples
+ *  an immutable @ref SiPMModel with a single @ref SiPMEventContext; to share
+ *  a model among many threads use the two classes directly.
  *
  *  @author Edoardo Proserpio
  *  @date 2020
@@ -13,11 +15,15 @@
 #include <cstdint>
 #include <iostream>
 #include <sstream>
+#include <utility>
 #include <vector>
 
 #include "SiPMAnalogSignal.h"
+#include "SiPMAnalogSignalView.h"
 #include "SiPMDebugInfo.h"
+#include "SiPMEventContext.h"
 #include "SiPMHit.h"
+#include "SiPMModel.h"
 #include "SiPMProperties.h"
 #include "SiPMRandom.h"
 #include "SiPMTypes.h"
@@ -33,29 +39,54 @@ public:
   SiPMSensor();
 
   /// @brief Returns the @ref SiPMProperties class stored in the SiPMSensor
-  const SiPMProperties& properties() const { return m_Properties; }
+  const SiPMProperties& properties() const { return m_Model.properties(); }
 
   /// @brief Returns the @ref SiPMAnalogSignal stored in the SiPMSensor
   /** Used to get the generated signal from the sensor. This method should be
    * run after @ref runEvent otherwise it will return only electronic noise.
    */
-  SiPMAnalogSignal signal() const { return m_Signal; }
+  const SiPMAnalogSignal& signal() const { return m_Context.signal(); }
 
-  /// @brief Returns vector containing all SiPMHits
+  /// @brief Returns a non-owning view of the signal of the last event
+  /** The view is valid until the next event is simulated. */
+  SiPMAnalogSignalView signalView() const { return m_Context.signalView(); }
+
+  /// @brief Moves the signal out of the sensor @sa SiPMEventContext::takeSignal
+  SiPMAnalogSignal takeSignal() { return m_Context.takeSignal(); }
+
+  /// @brief Gives back a signal obtained with @ref takeSignal to reuse its memory
+  void recycleSignal(SiPMAnalogSignal&& signal) { m_Context.recycleSignal(std::move(signal)); }
+
+  /// @brief Returns the @ref SiPMHitStore containing all hits
   /** This method allows to get all the hits generated in the simulation
-   * process, including noise hits.
+   * process, including noise hits. The store is owned by the sensor and is
+   * overwritten by the next event.
+   */
+  const SiPMHitStore& hits() const { return m_Context.hits(); }
+
+  /// @brief Returns the index of the parent hit of each hit
+  /** Hits that do not have a parent (photoelectrons and dark counts) have
+   * index equal to @ref SiPMHit::kNoParent.
    */
-  std::vector<SiPMHit*> hits() const { return m_Hits; }
+  const std::vector<int32_t>& hitsGraph() const { return m_Context.hitsGraph(); }
 
   /// @brief Returns the @ref SiPMRandom rng used by SiPMSensor
-  const SiPMRandom rng() const { return m_rng; }
+  const SiPMRandom rng() const { return m_Context.rng(); }
 
-  SiPMRandom& rng() { return m_rng; }
+  SiPMRandom& rng() { return m_Context.rng(); }
 
   /// @brief Returns a @ref SiPMDebugInfo struct with MC-Truth values
-  SiPMDebugInfo debug() const {
-    return SiPMDebugInfo{static_cast<uint32_t>(m_PhotonTimes.size()), m_nPe, m_nDcr, m_nXt, m_nDXt, m_nAp};
-  }
+  SiPMDebugInfo debug() const { return m_Context.debug(); }
+
+  /// @brief Returns the @ref SiPMModel used by the SiPMSensor
+  const SiPMModel& model() const { return m_Model; }
+
+  /// @brief Returns the @ref SiPMEventContext used by the SiPMSensor
+  const SiPMEventContext& context() const { return m_Context; }
+
+  /// @brief Returns the @ref SiPMEventContext used by the SiPMSensor
+  /** Can be used to set event and channel ids of the next event. */
+  SiPMEventContext& context() { return m_Context; }
 
   /// @brief Sets a property using its name
   /** For a list of available SiPM properties names @sa SiPMProperties.
@@ -80,9 +111,52 @@ public:
   /// @brief Adds multiple photons to the list of photons to be simulated at once
   void addPhotons(const std::vector<double>&, const std::vector<double>&);
 
+  /// @brief Adds a single photon hitting the sensor in a given position @sa SiPMEventContext::addPhoton
+  void addPhoton(const double, const double, const double, const double);
+
+  /// @brief Adds multiple photons with their positions at once @sa SiPMEventContext::addPhoton
+  void addPhotons(const std::vector<double>&, const std::vector<double>&, const std::vector<double>&,
+                  const std::vector<double>&);
+
+  /// @brief Sets n photons with their positions from raw buffers @sa SiPMEventContext::addPhotons
+  void addPhotons(const double*, const double*, const double*, const double*, const uint32_t);
+
+  /// @brief Sets n photons with their positions from raw buffers @sa SiPMEventContext::addPhotons
+  void addPhotons(const float*, const float*, const float*, const float*, const uint32_t);
+
   /// @brief Runs a complete SiPM event
   void runEvent();
 
+  /// @brief Runs a batch of SiPM events
+  /** Photons of all events are stored in a single flat vector and the photons
+   * of event i are the ones in range [offsets[i], offsets[i+1]) (CSR layout),
+   * hence offsets must have one more element than the number of events.
+   *
+   * The signal of event i is written in
+   * signals[i * nSignalPoints, (i + 1) * nSignalPoints), so signals must point
+   * to a buffer of at least nEvents * nSignalPoints floats. If debugs is not
+   * null the MC-Truth of event i is written in debugs[i].
+   *
+   * The internal state of the sensor is reset before each event. After the
+   * call @ref hits and @ref debug refer to the last event of the batch while
+   * @ref signal is not modified.
+   */
+  void runEvents(const std::vector<double>&, const std::vector<uint32_t>&, float*, SiPMDebugInfo* = nullptr);
+
+  /// @brief Runs a batch of SiPM events considering photon wavelengths
+  /** Same as @ref runEvents but wavelengths are stored in a flat vector with
+   * same layout as times.
+   */
+  void runEvents(const std::vector<double>&, const std::vector<double>&, const std::vector<uint32_t>&, float*,
+                 SiPMDebugInfo* = nullptr);
+
+  /// @brief Runs a batch of SiPM events using raw buffers
+  /** Core implementation of @ref runEvents. Offsets are indices in the times
+   * (and wavelengths) buffer so a sub-range of a larger batch can be simulated
+   * by passing offsets + first. Wavelengths can be null.
+   */
+  void runEvents(const double*, const double*, const uint32_t*, const uint32_t, float*, SiPMDebugInfo* = nullptr);
+
   /// @brief Resets internal state of the SiPMSensor
   /** Resets the SiPMSensor to a fresh state
    * so it can be used again for a new event. */
@@ -96,43 +170,8 @@ public:
   }
 
 private:
-  double evaluatePde(const double) const;
-  constexpr bool isInSensor(const int32_t r, const int32_t c) const noexcept {
-    const int32_t nSideCells = m_Properties.nSideCells();
-    return (r >= 0) & (c >= 0) & (r < nSideCells) & (c < nSideCells);
-  }
-  pair<uint32_t> hitUniform() const;
-  pair<uint32_t> hitCircle() const;
-  pair<uint32_t> hitGaussian() const;
-  pair<uint32_t> hitCell() const;
-  void signalShape();
-
-  void addDcrEvents();
-  void addPhotoelectrons();
-  void addCorrelatedNoise();
-
-  SiPMHit* generateXtHit(const SiPMHit*) const;
-  SiPMHit* generateApHit(const SiPMHit*) const;
-
-  void calculateSignalAmplitudes();
-  void generateSignal();
-
-  SiPMProperties m_Properties;
-  mutable SiPMRandom m_rng;
-
-  uint32_t m_nTotalHits = 0;
-  uint32_t m_nPe = 0;
-  uint32_t m_nDcr = 0;
-  uint32_t m_nXt = 0;
-  uint32_t m_nDXt = 0;
-  uint32_t m_nAp = 0;
-
-  std::vector<double> m_PhotonTimes;
-  std::vector<double> m_PhotonWavelengths;
-  std::vector<SiPMHit*> m_Hits;
-
-  std::vector<float> m_SignalShape;
-  SiPMAnalogSignal m_Signal;
+  SiPMModel m_Model;
+  SiPMEventContext m_Context;
 };
 
 } // namespace sipm
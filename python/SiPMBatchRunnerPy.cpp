@@ -0,0 +1,44 @@
+#include "SiPMBatchRunner.h"
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+using namespace sipm;
+
+void SiPMBatchRunnerPy(py::module& m) {
+  py::class_<SiPMBatchRunner> sipmbatchrunner(m, "SiPMBatchRunner");
+  sipmbatchrunner.def(py::init<>())
+    .def(py::init<const SiPMProperties&, const uint32_t>(), py::arg("properties"), py::arg("nThreads") = 0)
+    .def("properties", &SiPMBatchRunner::properties)
+    .def("nThreads", &SiPMBatchRunner::nThreads)
+    .def("setProperties", &SiPMBatchRunner::setProperties)
+    .def("seed", &SiPMBatchRunner::seed)
+    .def("setEngine", &SiPMBatchRunner::setEngine)
+    .def("eventId", &SiPMBatchRunner::eventId)
+    .def("setEventId", &SiPMBatchRunner::setEventId)
+    .def("runEvents",
+         [](SiPMBatchRunner& self, const std::vector<double>& times, const std::vector<uint32_t>& offsets) {
+           const py::ssize_t nEvents = offsets.size() < 2 ? 0 : offsets.size() - 1;
+           py::array_t<float> signals({nEvents, static_cast<py::ssize_t>(self.properties().nSignalPoints())});
+           std::vector<SiPMDebugInfo> debugs(nEvents);
+           {
+             py::gil_scoped_release release;
+             self.runEvents(times, offsets, signals.mutable_data(), debugs.data());
+           }
+           return py::make_tuple(signals, debugs);
+         })
+    .def("runEvents",
+         [](SiPMBatchRunner& self, const std::vector<double>& times, const std::vector<double>& wavelengths,
+            const std::vector<uint32_t>& offsets) {
+           const py::ssize_t nEvents = offsets.size() < 2 ? 0 : offsets.size() - 1;
+           py::array_t<float> signals({nEvents, static_cast<py::ssize_t>(self.properties().nSignalPoints())});
+           std::vector<SiPMDebugInfo> debugs(nEvents);
+           {
+             py::gil_scoped_release release;
+             self.runEvents(times, wavelengths, offsets, signals.mutable_data(), debugs.data());
+           }
+           return py::make_tuple(signals, debugs);
+         })
+    .def("__repr__", &SiPMBatchRunner::toString);
+}
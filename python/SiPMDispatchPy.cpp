@@ -0,0 +1,18 @@
+#include "SiPMDispatch.h"
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+using namespace sipm;
+
+void SiPMDispatchPy(py::module& m) {
+  py::module dispatch = m.def_submodule("SiPMDispatch", "Runtime selection of the instruction set");
+  py::enum_<SiPMDispatch::Backend>(dispatch, "Backend")
+    .value("kScalar", SiPMDispatch::Backend::kScalar)
+    .value("kAVX2", SiPMDispatch::Backend::kAVX2)
+    .value("kAVX512", SiPMDispatch::Backend::kAVX512);
+  dispatch.def("backend", &SiPMDispatch::backend)
+    .def("bestBackend", &SiPMDispatch::bestBackend)
+    .def("isSupported", &SiPMDispatch::isSupported)
+    .def("setBackend", &SiPMDispatch::setBackend)
+    .def("backendName", &SiPMDispatch::backendName);
+}
@@ -0,0 +1,29 @@
+#include "SiPMEventContext.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+using namespace sipm;
+
+void SiPMEventContextPy(py::module& m) {
+  py::class_<SiPMEventContext> sipmeventcontext(m, "SiPMEventContext");
+  sipmeventcontext.def(py::init<>())
+    .def(py::init<const uint64_t>())
+    .def(py::init<const uint64_t, const SiPMRandom::Engine>())
+    .def("eventId", &SiPMEventContext::eventId)
+    .def("setEventId", &SiPMEventContext::setEventId)
+    .def("channelId", &SiPMEventContext::channelId)
+    .def("setChannelId", &SiPMEventContext::setChannelId)
+    .def("signal", &SiPMEventContext::signal)
+    .def("hits", [](const SiPMEventContext& self) { return self.hits().toVector(); })
+    .def("hitsGraph", &SiPMEventContext::hitsGraph)
+    .def("debug", &SiPMEventContext::debug)
+    .def("rng", static_cast<SiPMRandom& (SiPMEventContext::*)()>(&SiPMEventContext::rng),
+         py::return_value_policy::reference_internal)
+    .def("addPhoton", py::overload_cast<const double>(&SiPMEventContext::addPhoton))
+    .def("addPhoton", py::overload_cast<const double, const double>(&SiPMEventContext::addPhoton))
+    .def("addPhotons", py::overload_cast<const std::vector<double>&>(&SiPMEventContext::addPhotons))
+    .def("addPhotons", py::overload_cast<const std::vector<double>&, const std::vector<double>&>(
+                         &SiPMEventContext::addPhotons))
+    .def("resetState", &SiPMEventContext::resetState);
+}
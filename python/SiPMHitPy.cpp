@@ -13,7 +13,7 @@ void SiPMHitPy(py::module& m) {
     .def("col", &SiPMHit::col)
     .def("amplitude", static_cast<float (SiPMHit::*)() const noexcept>(&SiPMHit::amplitude))
     .def("hitType", &SiPMHit::hitType)
-    .def("parent", &SiPMHit::parent, py::return_value_policy::reference)
+    .def("parent", &SiPMHit::parent)
     .def("__repr__", &SiPMHit::toString)
     .def("__deepcopy__", [](const SiPMHit& self, py::dict) { return SiPMHit(self); });
 
@@ -0,0 +1,16 @@
+#include "SiPMModel.h"
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+namespace py = pybind11;
+using namespace sipm;
+
+void SiPMModelPy(py::module& m) {
+  py::class_<SiPMModel, std::shared_ptr<SiPMModel>> sipmmodel(m, "SiPMModel");
+  sipmmodel.def(py::init<>())
+    .def(py::init<const SiPMProperties&>())
+    .def("properties", &SiPMModel::properties)
+    .def("signalShape", static_cast<const std::vector<float>& (SiPMModel::*)() const>(&SiPMModel::signalShape))
+    .def("runEvent", py::overload_cast<SiPMEventContext&>(&SiPMModel::runEvent, py::const_))
+    .def("__repr__", &SiPMModel::toString);
+}
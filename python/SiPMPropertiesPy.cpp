@@ -17,6 +17,14 @@ void SiPMPropertiesPy(py::module& m) {
     .def("nSideCells", &SiPMProperties::nSideCells)
     .def("nSignalPoints", &SiPMProperties::nSignalPoints)
     .def("hitDistribution", &SiPMProperties::hitDistribution)
+    .def("hitMap", &SiPMProperties::hitMap)
+    .def("hitMapRows", &SiPMProperties::hitMapRows)
+    .def("hitMapCols", &SiPMProperties::hitMapCols)
+    .def("recoveryMode", &SiPMProperties::recoveryMode)
+    .def("signalEngine", &SiPMProperties::signalEngine)
+    .def("noiseMode", &SiPMProperties::noiseMode)
+    .def("noiseBankSize", &SiPMProperties::noiseBankSize)
+    .def("noiseSpectrum", &SiPMProperties::noiseSpectrum)
     .def("signalLength", &SiPMProperties::signalLength)
     .def("sampling", &SiPMProperties::sampling)
     .def("risingTime", &SiPMProperties::risingTime)
@@ -38,6 +46,11 @@ void SiPMPropertiesPy(py::module& m) {
     .def("pde", &SiPMProperties::pde)
     .def("pdeSpectrum", &SiPMProperties::pdeSpectrum)
     .def("pdeType", &SiPMProperties::pdeType)
+    .def("pdeSampling", &SiPMProperties::pdeSampling)
+    .def("pulseTemplate", &SiPMProperties::pulseTemplate)
+    .def("pulseTemplateSampling", &SiPMProperties::pulseTemplateSampling)
+    .def("pulsePhases", &SiPMProperties::pulsePhases)
+    .def("hasPulseTemplate", &SiPMProperties::hasPulseTemplate)
     .def("hasDcr", &SiPMProperties::hasDcr)
     .def("hasXt", &SiPMProperties::hasXt)
     .def("hasDXt", &SiPMProperties::hasDXt)
@@ -75,9 +88,21 @@ void SiPMPropertiesPy(py::module& m) {
     .def("setApOn", &SiPMProperties::setApOn)
     .def("setSlowComponentOn", &SiPMProperties::setSlowComponentOn)
     .def("setPdeType", &SiPMProperties::setPdeType)
+    .def("setPdeSampling", &SiPMProperties::setPdeSampling)
     .def("setPdeSpectrum",
          py::overload_cast<const vector<double>&, const vector<double>&>(&SiPMProperties::setPdeSpectrum))
+    .def("setPdeSpectrum", py::overload_cast<const vector<double>&, const vector<double>&, const uint32_t>(
+                             &SiPMProperties::setPdeSpectrum))
+    .def("setPulseTemplate", &SiPMProperties::setPulseTemplate)
+    .def("clearPulseTemplate", &SiPMProperties::clearPulseTemplate)
+    .def("setPulsePhases", &SiPMProperties::setPulsePhases)
     .def("setHitDistribution", &SiPMProperties::setHitDistribution)
+    .def("setHitMap", &SiPMProperties::setHitMap)
+    .def("setRecoveryMode", &SiPMProperties::setRecoveryMode)
+    .def("setSignalEngine", &SiPMProperties::setSignalEngine)
+    .def("setNoiseMode", &SiPMProperties::setNoiseMode)
+    .def("setNoiseBankSize", &SiPMProperties::setNoiseBankSize)
+    .def("setNoiseSpectrum", &SiPMProperties::setNoiseSpectrum)
     .def("__repr__", &SiPMProperties::toString);
 
   py::enum_<SiPMProperties::PdeType>(sipmproperties, "PdeType")
@@ -85,8 +110,27 @@ void SiPMPropertiesPy(py::module& m) {
     .value("kSimplePde", SiPMProperties::PdeType::kSimplePde)
     .value("kSpectrumPde", SiPMProperties::PdeType::kSpectrumPde);
 
+  py::enum_<SiPMProperties::PdeSampling>(sipmproperties, "PdeSampling")
+    .value("kPerPhoton", SiPMProperties::PdeSampling::kPerPhoton)
+    .value("kBinomial", SiPMProperties::PdeSampling::kBinomial);
+
   py::enum_<SiPMProperties::HitDistribution>(sipmproperties, "HitDistribution")
     .value("kUniform", SiPMProperties::HitDistribution::kUniform)
     .value("kGaussian", SiPMProperties::HitDistribution::kGaussian)
-    .value("kCircle", SiPMProperties::HitDistribution::kCircle);
+    .value("kCircle", SiPMProperties::HitDistribution::kCircle)
+    .value("kCustomMap", SiPMProperties::HitDistribution::kCustomMap);
+
+  py::enum_<SiPMProperties::RecoveryMode>(sipmproperties, "RecoveryMode")
+    .value("kPerCell", SiPMProperties::RecoveryMode::kPerCell)
+    .value("kTimeSorted", SiPMProperties::RecoveryMode::kTimeSorted);
+
+  py::enum_<SiPMProperties::SignalEngine>(sipmproperties, "SignalEngine")
+    .value("kAuto", SiPMProperties::SignalEngine::kAuto)
+    .value("kDirect", SiPMProperties::SignalEngine::kDirect)
+    .value("kRecursive", SiPMProperties::SignalEngine::kRecursive)
+    .value("kFft", SiPMProperties::SignalEngine::kFft);
+
+  py::enum_<SiPMProperties::NoiseMode>(sipmproperties, "NoiseMode")
+    .value("kGenerated", SiPMProperties::NoiseMode::kGenerated)
+    .value("kBank", SiPMProperties::NoiseMode::kBank);
 }
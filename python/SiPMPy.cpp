@@ -11,6 +11,10 @@ void SiPMDebugInfoPy(py::module&);
 void SiPMHitPy(py::module&);
 void SiPMSensorPy(py::module&);
 void SiPMRandomPy(py::module&);
+void SiPMBatchRunnerPy(py::module&);
+void SiPMModelPy(py::module&);
+void SiPMEventContextPy(py::module&);
+void SiPMDispatchPy(py::module&);
 
 PYBIND11_MODULE(SiPM, m) {
   m.doc() = "Module for SiPM simulation";
@@ -21,4 +25,8 @@ PYBIND11_MODULE(SiPM, m) {
   SiPMHitPy(m);
   SiPMSensorPy(m);
   SiPMRandomPy(m);
+  SiPMBatchRunnerPy(m);
+  SiPMModelPy(m);
+  SiPMEventContextPy(m);
+  SiPMDispatchPy(m);
 }
@@ -10,12 +10,21 @@ using namespace sipm;
 void SiPMRandomPy(py::module& m) {
   py::class_<SiPMRandom> SiPMRandom(m, "SiPMRandom");
   SiPMRandom.def(py::init<>())
+    .def(py::init<const SiPMRandom::Engine>())
+    .def("engine", &SiPMRandom::engine)
+    .def("isCounterBased", &SiPMRandom::isCounterBased)
+    .def("setStream", &SiPMRandom::setStream, py::arg("eventId"), py::arg("channelId") = 0)
     .def("seed", static_cast<void (SiPMRandom::*)(const uint64_t)>(&SiPMRandom::seed))
+    .def("jump", &SiPMRandom::jump)
+    .def("split", &SiPMRandom::split)
     .def("Rand", static_cast<double (SiPMRandom::*)(void)>(&SiPMRandom::Rand))
     .def("randInteger", static_cast<uint32_t (SiPMRandom::*)(const uint32_t)>(&SiPMRandom::randInteger))
     .def("randGaussian", static_cast<double (SiPMRandom::*)(const double, const double)>(&SiPMRandom::randGaussian))
     .def("randExponential", static_cast<double (SiPMRandom::*)(double)>(&SiPMRandom::randExponential))
+    .def("randExponentialTrunc",
+         static_cast<double (SiPMRandom::*)(const double, const double)>(&SiPMRandom::randExponentialTrunc))
     .def("randPoisson", &SiPMRandom::randPoisson)
+    .def("randBinomial", &SiPMRandom::randBinomial)
     .def("Rand", static_cast<std::vector<double> (SiPMRandom::*)(const uint32_t)>(&SiPMRandom::Rand))
     .def("randGaussian", static_cast<std::vector<double> (SiPMRandom::*)(const double, const double, const uint32_t)>(
                            &SiPMRandom::randGaussian))
@@ -25,5 +34,12 @@ void SiPMRandomPy(py::module& m) {
     .def("randInteger",
          static_cast<std::vector<uint32_t> (SiPMRandom::*)(const uint32_t, const uint32_t)>(&SiPMRandom::randInteger))
     .def("randExponential",
-         static_cast<std::vector<double> (SiPMRandom::*)(const double, const uint32_t)>(&SiPMRandom::randExponential));
+         static_cast<std::vector<double> (SiPMRandom::*)(const double, const uint32_t)>(&SiPMRandom::randExponential))
+    .def("randExponentialTrunc",
+         static_cast<std::vector<double> (SiPMRandom::*)(const double, const double, const uint32_t)>(
+           &SiPMRandom::randExponentialTrunc));
+
+  py::enum_<SiPMRandom::Engine>(SiPMRandom, "Engine")
+    .value("kXorshift256plus", SiPMRandom::Engine::kXorshift256plus)
+    .value("kPhilox4x32", SiPMRandom::Engine::kPhilox4x32);
 }
@@ -1,7 +1,9 @@
 #include "SiPMSensor.h"
 #include <pybind11/iostream.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <utility>
 
 namespace py = pybind11;
 using namespace sipm;
@@ -11,8 +13,11 @@ void SiPMSensorPy(py::module& m) {
   sipmsensor.def(py::init<>())
     .def(py::init<const SiPMProperties&>())
     .def("properties", static_cast<const SiPMProperties& (SiPMSensor::*)() const>(&SiPMSensor::properties))
-    .def("hits", &SiPMSensor::hits, py::return_value_policy::reference_internal)
+    .def("hits", [](const SiPMSensor& self) { return self.hits().toVector(); })
+    .def("hitsGraph", &SiPMSensor::hitsGraph)
     .def("signal", &SiPMSensor::signal)
+    .def("takeSignal", &SiPMSensor::takeSignal)
+    .def("recycleSignal", [](SiPMSensor& self, SiPMAnalogSignal& signal) { self.recycleSignal(std::move(signal)); })
     .def("rng", static_cast<const SiPMRandom (SiPMSensor::*)() const>(&SiPMSensor::rng))
     .def("debug", &SiPMSensor::debug)
     .def("setProperty", &SiPMSensor::setProperty)
@@ -22,7 +27,29 @@ void SiPMSensorPy(py::module& m) {
     .def("addPhotons", py::overload_cast<const std::vector<double>&>(&SiPMSensor::addPhotons))
     .def("addPhotons",
          py::overload_cast<const std::vector<double>&, const std::vector<double>&>(&SiPMSensor::addPhotons))
+    .def("addPhoton",
+         py::overload_cast<const double, const double, const double, const double>(&SiPMSensor::addPhoton))
+    .def("addPhotons", py::overload_cast<const std::vector<double>&, const std::vector<double>&,
+                                         const std::vector<double>&, const std::vector<double>&>(
+                         &SiPMSensor::addPhotons))
     .def("runEvent", &SiPMSensor::runEvent)
+    .def("runEvents",
+         [](SiPMSensor& self, const std::vector<double>& times, const std::vector<uint32_t>& offsets) {
+           const py::ssize_t nEvents = offsets.size() < 2 ? 0 : offsets.size() - 1;
+           py::array_t<float> signals({nEvents, static_cast<py::ssize_t>(self.properties().nSignalPoints())});
+           std::vector<SiPMDebugInfo> debugs(nEvents);
+           self.runEvents(times, offsets, signals.mutable_data(), debugs.data());
+           return py::make_tuple(signals, debugs);
+         })
+    .def("runEvents",
+         [](SiPMSensor& self, const std::vector<double>& times, const std::vector<double>& wavelengths,
+            const std::vector<uint32_t>& offsets) {
+           const py::ssize_t nEvents = offsets.size() < 2 ? 0 : offsets.size() - 1;
+           py::array_t<float> signals({nEvents, static_cast<py::ssize_t>(self.properties().nSignalPoints())});
+           std::vector<SiPMDebugInfo> debugs(nEvents);
+           self.runEvents(times, wavelengths, offsets, signals.mutable_data(), debugs.data());
+           return py::make_tuple(signals, debugs);
+         })
     .def("resetState", &SiPMSensor::resetState)
     .def("__repr__", &SiPMSensor::toString);
 }
@@ -34,7 +34,7 @@ for l in open("include/SiPM.h").readlines():
         __version__ = l.split()[-1].strip('"')
         break
 
-# Optimize for modern CPUs
+# Optimize for modern CPUs, keep in sync with .github/workflows/wheel-flags.yml
 extra_compile_args = [
     "-DNDEBUG",
     "-O3",
@@ -0,0 +1,73 @@
+#include "SiPMAliasTable.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace sipm {
+SiPMAliasTable::SiPMAliasTable(const std::vector<double>& weights) {
+  const uint32_t n = weights.size();
+  m_Prob.resize(n);
+  m_Alias.resize(n);
+  if (n == 0) {
+    return;
+  }
+
+  double sum = 0;
+  for (const double w : weights) {
+    sum += w;
+  }
+  // Weights scaled to an average of 1
+  std::vector<double> scaled(n, 1);
+  if (sum > 0) {
+    for (uint32_t i = 0; i < n; ++i) {
+      scaled[i] = weights[i] * n / sum;
+    }
+  }
+
+  std::vector<uint32_t> small;
+  std::vector<uint32_t> large;
+  small.reserve(n);
+  large.reserve(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    (scaled[i] < 1 ? small : large).push_back(i);
+  }
+
+  // Each small bin is filled up to 1 using part of a large bin
+  while (!small.empty() && !large.empty()) {
+    const uint32_t s = small.back();
+    const uint32_t l = large.back();
+    small.pop_back();
+    large.pop_back();
+    m_Prob[s] = scaled[s];
+    m_Alias[s] = l;
+    scaled[l] = (scaled[l] + scaled[s]) - 1;
+    (scaled[l] < 1 ? small : large).push_back(l);
+  }
+  // Leftovers are 1 up to rounding errors
+  for (const uint32_t i : large) {
+    m_Prob[i] = 1;
+    m_Alias[i] = i;
+  }
+  for (const uint32_t i : small) {
+    m_Prob[i] = 1;
+    m_Alias[i] = i;
+  }
+}
+
+void SiPMAliasTable::sample(SiPMRandom& rng, const uint32_t n, uint32_t* out) const noexcept {
+  constexpr uint32_t kChunk = 256;
+  float u[kChunk];
+  const float* prob = m_Prob.data();
+  const uint32_t* alias = m_Alias.data();
+  for (uint32_t i = 0; i < n; i += kChunk) {
+    const uint32_t m = std::min(kChunk, n - i);
+    uint32_t* idx = out + i;
+    rng.randInteger(m_Prob.size(), m, idx);
+    rng.RandF(m, u);
+    for (uint32_t j = 0; j < m; ++j) {
+      idx[j] = u[j] < prob[idx[j]] ? idx[j] : alias[idx[j]];
+    }
+  }
+}
+} // namespace sipm
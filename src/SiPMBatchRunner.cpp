@@ -0,0 +1,100 @@
+#include "SiPMBatchRunner.h"
+#include "SiPMDebugInfo.h"
+#include "SiPMEventContext.h"
+#include "SiPMModel.h"
+#include "SiPMProperties.h"
+#include "SiPMRandom.h"
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+namespace sipm {
+SiPMBatchRunner::SiPMBatchRunner(const SiPMProperties& aProperty, const uint32_t nThreads) : m_Model(aProperty) {
+  const uint32_t n = nThreads > 0 ? nThreads : std::max(1u, std::thread::hardware_concurrency());
+  m_Contexts.resize(n);
+}
+
+void SiPMBatchRunner::setProperties(const SiPMProperties& val) { m_Model = SiPMModel(val); }
+
+void SiPMBatchRunner::setEngine(const SiPMRandom::Engine engine) {
+  for (auto& context : m_Contexts) {
+    context.rng() = SiPMRandom(engine);
+  }
+  if (m_Seeded) {
+    // Seed of the new engine is the same, event id is left unchanged
+    const uint64_t eventId = m_EventId;
+    seed(m_Seed);
+    m_EventId = eventId;
+  }
+}
+
+void SiPMBatchRunner::seed(const uint64_t aseed) {
+  m_Seed = aseed;
+  m_Seeded = true;
+  m_EventId = 0;
+  SiPMRandom& first = m_Contexts.front().rng();
+  first.seed(aseed);
+  for (uint32_t i = 1; i < m_Contexts.size(); ++i) {
+    if (first.isCounterBased()) {
+      // Streams are selected using event ids
+      m_Contexts[i].rng().seed(aseed);
+    } else {
+      // Workers use non-overlapping substreams of the same generator
+      m_Contexts[i].rng() = first.split(i);
+    }
+  }
+}
+
+void SiPMBatchRunner::runEvents(const std::vector<double>& times, const std::vector<uint32_t>& offsets,
+                                float* signals, SiPMDebugInfo* debugs) {
+  if (offsets.size() < 2) { return; }
+  runEvents(times.data(), nullptr, offsets.data(), offsets.size() - 1, signals, debugs);
+}
+
+void SiPMBatchRunner::runEvents(const std::vector<double>& times, const std::vector<double>& wavelengths,
+                                const std::vector<uint32_t>& offsets, float* signals, SiPMDebugInfo* debugs) {
+  if (offsets.size() < 2) { return; }
+  runEvents(times.data(), wavelengths.data(), offsets.data(), offsets.size() - 1, signals, debugs);
+}
+
+void SiPMBatchRunner::runEvents(const double* times, const double* wavelengths, const uint32_t* offsets,
+                                const uint32_t nEvents, float* signals, SiPMDebugInfo* debugs) {
+  const uint32_t nWorkers = std::min<uint32_t>(m_Contexts.size(), nEvents);
+  if (nWorkers == 0) { return; }
+  const size_t nSignalPoints = properties().nSignalPoints();
+
+  // Each worker simulates a contiguous range of events. A static partition
+  // makes results reproducible for a given seed and number of threads.
+  auto work = [&](const uint32_t workerIdx) {
+    const uint32_t first = static_cast<uint64_t>(nEvents) * workerIdx / nWorkers;
+    const uint32_t last = static_cast<uint64_t>(nEvents) * (workerIdx + 1) / nWorkers;
+    m_Contexts[workerIdx].setEventId(m_EventId + first);
+    m_Model.runEvents(m_Contexts[workerIdx], times, wavelengths, offsets + first, last - first,
+                      signals + first * nSignalPoints, debugs ? debugs + first : nullptr);
+  };
+
+  // Calling thread is used as first worker
+  std::vector<std::thread> threads;
+  threads.reserve(nWorkers - 1);
+  for (uint32_t i = 1; i < nWorkers; ++i) {
+    threads.emplace_back(work, i);
+  }
+  work(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  m_EventId += nEvents;
+}
+
+std::ostream& operator<<(std::ostream& out, const SiPMBatchRunner& obj) {
+  out << std::setprecision(2) << std::fixed;
+  out << "===> SiPM Batch Runner <===\n";
+  out << "Address: " << std::hex << std::addressof(obj) << "\n";
+  out << "Number of threads: " << std::dec << obj.nThreads() << "\n";
+  out << obj.properties();
+  return out;
+}
+} // namespace sipm
@@ -0,0 +1,383 @@
+#include "SiPMDispatch.h"
+
+#include "SiPMRandom.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+// Kernels for AVX2 and AVX512 are compiled with target attributes, so the
+// rest of the library can be built for the baseline instruction set
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SIPM_DISPATCH_X86
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace sipm {
+namespace SiPMDispatch {
+namespace {
+// Philox4x32-10 constants
+constexpr uint32_t M0 = 0xD2511F53;
+constexpr uint32_t M1 = 0xCD9E8D57;
+constexpr uint32_t W0 = 0x9E3779B9;
+constexpr uint32_t W1 = 0xBB67AE85;
+
+#if defined(__SSE2__)
+void xoshiro256plusScalar(uint64_t (&state)[4][8], void* out, const uint32_t n) noexcept {
+  // Lanes 0-1, 2-3, 4-5 and 6-7 of each word
+  __m128i __s[4][4];
+  for (int i = 0; i < 4; ++i) {
+    for (int h = 0; h < 4; ++h) {
+      __s[i][h] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state[i] + 2 * h));
+    }
+  }
+  __m128i* dst = static_cast<__m128i*>(out);
+  for (uint32_t k = 0; k < n; ++k) {
+    for (int h = 0; h < 4; ++h) {
+      _mm_storeu_si128(dst + 4 * k + h, _mm_add_epi64(__s[0][h], __s[3][h]));
+
+      const __m128i __t = _mm_slli_epi64(__s[1][h], 17);
+
+      __s[2][h] = _mm_xor_si128(__s[2][h], __s[0][h]);
+      __s[3][h] = _mm_xor_si128(__s[3][h], __s[1][h]);
+      __s[1][h] = _mm_xor_si128(__s[1][h], __s[2][h]);
+      __s[0][h] = _mm_xor_si128(__s[0][h], __s[3][h]);
+
+      __s[2][h] = _mm_xor_si128(__s[2][h], __t);
+
+      __s[3][h] = _mm_or_si128(_mm_slli_epi64(__s[3][h], 45), _mm_srli_epi64(__s[3][h], 64 - 45));
+    }
+  }
+  for (int i = 0; i < 4; ++i) {
+    for (int h = 0; h < 4; ++h) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(state[i] + 2 * h), __s[i][h]);
+    }
+  }
+}
+#else
+void xoshiro256plusScalar(uint64_t (&state)[4][8], void* out, const uint32_t n) noexcept {
+  uint64_t s[4][8];
+  std::memcpy(s, state, sizeof(s));
+  unsigned char* dst = static_cast<unsigned char*>(out);
+  for (uint32_t k = 0; k < n; ++k) {
+    // Lanes are independent, loop is vectorized by the compiler
+    uint64_t r[8];
+    for (int l = 0; l < 8; ++l) {
+      r[l] = s[0][l] + s[3][l];
+      const uint64_t t = s[1][l] << 17;
+      s[2][l] ^= s[0][l];
+      s[3][l] ^= s[1][l];
+      s[1][l] ^= s[2][l];
+      s[0][l] ^= s[3][l];
+      s[2][l] ^= t;
+      s[3][l] = (s[3][l] << 45) | (s[3][l] >> (64 - 45));
+    }
+    std::memcpy(dst + k * sizeof(r), r, sizeof(r));
+  }
+  std::memcpy(state, s, sizeof(s));
+}
+#endif
+
+#if defined(__SSE2__)
+void philox4x32Scalar(const uint32_t (&counter)[4], const uint32_t (&key)[2], uint32_t (&out)[4][16]) noexcept {
+  const __m128i __lo = _mm_set_epi32(0, -1, 0, -1);
+  const __m128i __hi = _mm_set_epi32(-1, 0, -1, 0);
+  const __m128i __m0 = _mm_set1_epi32(M0);
+  const __m128i __m1 = _mm_set1_epi32(M1);
+  // 4 counters per vector
+  for (uint32_t g = 0; g < 16; g += 4) {
+    __m128i __c0 = _mm_add_epi32(_mm_set1_epi32(counter[0] + g), _mm_setr_epi32(0, 1, 2, 3));
+    __m128i __c1 = _mm_set1_epi32(counter[1]);
+    __m128i __c2 = _mm_set1_epi32(counter[2]);
+    __m128i __c3 = _mm_set1_epi32(counter[3]);
+    __m128i __k0 = _mm_set1_epi32(key[0]);
+    __m128i __k1 = _mm_set1_epi32(key[1]);
+    for (int r = 0; r < 10; ++r) {
+      // 32x32->64 products of even and odd lanes
+      const __m128i __p0e = _mm_mul_epu32(__c0, __m0);
+      const __m128i __p0o = _mm_mul_epu32(_mm_srli_epi64(__c0, 32), __m0);
+      const __m128i __p1e = _mm_mul_epu32(__c2, __m1);
+      const __m128i __p1o = _mm_mul_epu32(_mm_srli_epi64(__c2, 32), __m1);
+      const __m128i __lo0 = _mm_or_si128(_mm_and_si128(__p0e, __lo), _mm_slli_epi64(__p0o, 32));
+      const __m128i __hi0 = _mm_or_si128(_mm_srli_epi64(__p0e, 32), _mm_and_si128(__p0o, __hi));
+      const __m128i __lo1 = _mm_or_si128(_mm_and_si128(__p1e, __lo), _mm_slli_epi64(__p1o, 32));
+      const __m128i __hi1 = _mm_or_si128(_mm_srli_epi64(__p1e, 32), _mm_and_si128(__p1o, __hi));
+      __c0 = _mm_xor_si128(_mm_xor_si128(__hi1, __c1), __k0);
+      __c1 = __lo1;
+      __c2 = _mm_xor_si128(_mm_xor_si128(__hi0, __c3), __k1);
+      __c3 = __lo0;
+      __k0 = _mm_add_epi32(__k0, _mm_set1_epi32(W0));
+      __k1 = _mm_add_epi32(__k1, _mm_set1_epi32(W1));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[0] + g), __c0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[1] + g), __c1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[2] + g), __c2);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[3] + g), __c3);
+  }
+}
+#else
+void philox4x32Scalar(const uint32_t (&counter)[4], const uint32_t (&key)[2], uint32_t (&out)[4][16]) noexcept {
+  for (uint32_t l = 0; l < 16; ++l) {
+    const std::array<uint32_t, 4> ctr =
+      SiPMRng::Philox4x32::block({counter[0] + l, counter[1], counter[2], counter[3]}, {key[0], key[1]});
+    for (int i = 0; i < 4; ++i) {
+      out[i][l] = ctr[i];
+    }
+  }
+}
+#endif
+
+void accumulateScalar(float* __restrict__ y, const float* __restrict__ x, const float a, const uint32_t n) noexcept {
+  for (uint32_t i = 0; i < n; ++i) {
+    y[i] += x[i] * a;
+  }
+}
+
+#ifdef SIPM_DISPATCH_X86
+__attribute__((target("avx2"))) void xoshiro256plusAVX2(uint64_t (&state)[4][8], void* out,
+                                                         const uint32_t n) noexcept {
+  // Lanes 0-3 and 4-7 of each word
+  __m256i __s[4][2];
+  for (int i = 0; i < 4; ++i) {
+    __s[i][0] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state[i]));
+    __s[i][1] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state[i] + 4));
+  }
+  __m256i* dst = static_cast<__m256i*>(out);
+  for (uint32_t k = 0; k < n; ++k) {
+    for (int h = 0; h < 2; ++h) {
+      _mm256_storeu_si256(dst + 2 * k + h, _mm256_add_epi64(__s[0][h], __s[3][h]));
+
+      const __m256i __t = _mm256_slli_epi64(__s[1][h], 17);
+
+      __s[2][h] = _mm256_xor_si256(__s[2][h], __s[0][h]);
+      __s[3][h] = _mm256_xor_si256(__s[3][h], __s[1][h]);
+      __s[1][h] = _mm256_xor_si256(__s[1][h], __s[2][h]);
+      __s[0][h] = _mm256_xor_si256(__s[0][h], __s[3][h]);
+
+      __s[2][h] = _mm256_xor_si256(__s[2][h], __t);
+
+      __s[3][h] = _mm256_or_si256(_mm256_slli_epi64(__s[3][h], 45), _mm256_srli_epi64(__s[3][h], 64 - 45));
+    }
+  }
+  for (int i = 0; i < 4; ++i) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(state[i]), __s[i][0]);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(state[i] + 4), __s[i][1]);
+  }
+}
+
+__attribute__((target("avx2"))) void philox4x32AVX2(const uint32_t (&counter)[4], const uint32_t (&key)[2],
+                                                     uint32_t (&out)[4][16]) noexcept {
+  const __m256i __lo = _mm256_set1_epi64x(0xffffffff);
+  const __m256i __hi = _mm256_set1_epi64x(0xffffffff00000000);
+  const __m256i __m0 = _mm256_set1_epi32(M0);
+  const __m256i __m1 = _mm256_set1_epi32(M1);
+  // 8 counters per vector
+  for (uint32_t g = 0; g < 16; g += 8) {
+    __m256i __c0 = _mm256_add_epi32(_mm256_set1_epi32(counter[0] + g), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i __c1 = _mm256_set1_epi32(counter[1]);
+    __m256i __c2 = _mm256_set1_epi32(counter[2]);
+    __m256i __c3 = _mm256_set1_epi32(counter[3]);
+    __m256i __k0 = _mm256_set1_epi32(key[0]);
+    __m256i __k1 = _mm256_set1_epi32(key[1]);
+    for (int r = 0; r < 10; ++r) {
+      // 32x32->64 products of even and odd lanes
+      const __m256i __p0e = _mm256_mul_epu32(__c0, __m0);
+      const __m256i __p0o = _mm256_mul_epu32(_mm256_srli_epi64(__c0, 32), __m0);
+      const __m256i __p1e = _mm256_mul_epu32(__c2, __m1);
+      const __m256i __p1o = _mm256_mul_epu32(_mm256_srli_epi64(__c2, 32), __m1);
+      const __m256i __lo0 = _mm256_or_si256(_mm256_and_si256(__p0e, __lo), _mm256_slli_epi64(__p0o, 32));
+      const __m256i __hi0 = _mm256_or_si256(_mm256_srli_epi64(__p0e, 32), _mm256_and_si256(__p0o, __hi));
+      const __m256i __lo1 = _mm256_or_si256(_mm256_and_si256(__p1e, __lo), _mm256_slli_epi64(__p1o, 32));
+      const __m256i __hi1 = _mm256_or_si256(_mm256_srli_epi64(__p1e, 32), _mm256_and_si256(__p1o, __hi));
+      __c0 = _mm256_xor_si256(_mm256_xor_si256(__hi1, __c1), __k0);
+      __c1 = __lo1;
+      __c2 = _mm256_xor_si256(_mm256_xor_si256(__hi0, __c3), __k1);
+      __c3 = __lo0;
+      __k0 = _mm256_add_epi32(__k0, _mm256_set1_epi32(W0));
+      __k1 = _mm256_add_epi32(__k1, _mm256_set1_epi32(W1));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out[0] + g), __c0);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out[1] + g), __c1);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out[2] + g), __c2);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out[3] + g), __c3);
+  }
+}
+
+// Same source as the scalar version, vectorized by the compiler
+__attribute__((target("avx2,fma"))) void accumulateAVX2(float* __restrict__ y, const float* __restrict__ x,
+                                                         const float a, const uint32_t n) noexcept {
+  for (uint32_t i = 0; i < n; ++i) {
+    y[i] += x[i] * a;
+  }
+}
+
+__attribute__((target("avx512f"))) void xoshiro256plusAVX512(uint64_t (&state)[4][8], void* out,
+                                                              const uint32_t n) noexcept {
+  // Masked forms with all lanes set: the plain intrinsics of GCC 12 read an
+  // undefined source operand and warn when AVX512 is only a target attribute
+  constexpr __mmask8 kAll = 0xff;
+  __m512i __s[4];
+  for (int i = 0; i < 4; ++i) {
+    __s[i] = _mm512_loadu_si512(state[i]);
+  }
+  __m512i* dst = static_cast<__m512i*>(out);
+  for (uint32_t k = 0; k < n; ++k) {
+    _mm512_storeu_si512(dst + k, _mm512_add_epi64(__s[0], __s[3]));
+
+    const __m512i __t = _mm512_maskz_slli_epi64(kAll, __s[1], 17);
+
+    __s[2] = _mm512_xor_si512(__s[2], __s[0]);
+    __s[3] = _mm512_xor_si512(__s[3], __s[1]);
+    __s[1] = _mm512_xor_si512(__s[1], __s[2]);
+    __s[0] = _mm512_xor_si512(__s[0], __s[3]);
+
+    __s[2] = _mm512_xor_si512(__s[2], __t);
+
+    __s[3] = _mm512_maskz_rol_epi64(kAll, __s[3], 45);
+  }
+  for (int i = 0; i < 4; ++i) {
+    _mm512_storeu_si512(state[i], __s[i]);
+  }
+}
+
+__attribute__((target("avx512f"))) void philox4x32AVX512(const uint32_t (&counter)[4], const uint32_t (&key)[2],
+                                                          uint32_t (&out)[4][16]) noexcept {
+  constexpr __mmask8 kAll = 0xff;
+  const __m512i __lo = _mm512_set1_epi64(0xffffffff);
+  const __m512i __hi = _mm512_set1_epi64(0xffffffff00000000);
+  const __m512i __m0 = _mm512_set1_epi32(M0);
+  const __m512i __m1 = _mm512_set1_epi32(M1);
+  __m512i __c0 = _mm512_add_epi32(_mm512_set1_epi32(counter[0]),
+                                  _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+  __m512i __c1 = _mm512_set1_epi32(counter[1]);
+  __m512i __c2 = _mm512_set1_epi32(counter[2]);
+  __m512i __c3 = _mm512_set1_epi32(counter[3]);
+  __m512i __k0 = _mm512_set1_epi32(key[0]);
+  __m512i __k1 = _mm512_set1_epi32(key[1]);
+  for (int r = 0; r < 10; ++r) {
+    // 32x32->64 products of even and odd lanes
+    const __m512i __p0e = _mm512_maskz_mul_epu32(kAll, __c0, __m0);
+    const __m512i __p0o = _mm512_maskz_mul_epu32(kAll, _mm512_maskz_srli_epi64(kAll, __c0, 32), __m0);
+    const __m512i __p1e = _mm512_maskz_mul_epu32(kAll, __c2, __m1);
+    const __m512i __p1o = _mm512_maskz_mul_epu32(kAll, _mm512_maskz_srli_epi64(kAll, __c2, 32), __m1);
+    const __m512i __lo0 = _mm512_or_si512(_mm512_and_si512(__p0e, __lo), _mm512_maskz_slli_epi64(kAll, __p0o, 32));
+    const __m512i __hi0 = _mm512_or_si512(_mm512_maskz_srli_epi64(kAll, __p0e, 32), _mm512_and_si512(__p0o, __hi));
+    const __m512i __lo1 = _mm512_or_si512(_mm512_and_si512(__p1e, __lo), _mm512_maskz_slli_epi64(kAll, __p1o, 32));
+    const __m512i __hi1 = _mm512_or_si512(_mm512_maskz_srli_epi64(kAll, __p1e, 32), _mm512_and_si512(__p1o, __hi));
+    __c0 = _mm512_xor_si512(_mm512_xor_si512(__hi1, __c1), __k0);
+    __c1 = __lo1;
+    __c2 = _mm512_xor_si512(_mm512_xor_si512(__hi0, __c3), __k1);
+    __c3 = __lo0;
+    __k0 = _mm512_add_epi32(__k0, _mm512_set1_epi32(W0));
+    __k1 = _mm512_add_epi32(__k1, _mm512_set1_epi32(W1));
+  }
+  _mm512_storeu_si512(out[0], __c0);
+  _mm512_storeu_si512(out[1], __c1);
+  _mm512_storeu_si512(out[2], __c2);
+  _mm512_storeu_si512(out[3], __c3);
+}
+
+__attribute__((target("avx512f"))) void accumulateAVX512(float* __restrict__ y, const float* __restrict__ x,
+                                                          const float a, const uint32_t n) noexcept {
+  for (uint32_t i = 0; i < n; ++i) {
+    y[i] += x[i] * a;
+  }
+}
+#endif
+
+Backend detectBackend() noexcept {
+#ifdef SIPM_DISPATCH_X86
+  // Checks both cpuid and the registers saved by the OS
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return Backend::kAVX512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return Backend::kAVX2;
+  }
+#endif
+  return Backend::kScalar;
+}
+
+// Constant initialized to kScalar, so kernels called by static initializers
+// of other libraries before the detection are still valid
+std::atomic<Backend> g_Backend{Backend::kScalar};
+[[maybe_unused]] const bool g_Detected = [] {
+  g_Backend.store(detectBackend(), std::memory_order_relaxed);
+  return true;
+}();
+} // namespace
+
+Backend backend() noexcept { return g_Backend.load(std::memory_order_relaxed); }
+
+Backend bestBackend() noexcept { return detectBackend(); }
+
+bool isSupported(const Backend b) noexcept { return b <= bestBackend(); }
+
+bool setBackend(const Backend b) noexcept {
+  if (!isSupported(b)) {
+    return false;
+  }
+  g_Backend.store(b, std::memory_order_relaxed);
+  return true;
+}
+
+const char* backendName(const Backend b) noexcept {
+  switch (b) {
+    case Backend::kScalar:
+      return "scalar";
+    case Backend::kAVX2:
+      return "avx2";
+    case Backend::kAVX512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+void xoshiro256plus(uint64_t (&state)[4][8], void* out, const uint32_t n) noexcept {
+  switch (backend()) {
+#ifdef SIPM_DISPATCH_X86
+    case Backend::kAVX512:
+      xoshiro256plusAVX512(state, out, n);
+      return;
+    case Backend::kAVX2:
+      xoshiro256plusAVX2(state, out, n);
+      return;
+#endif
+    default:
+      xoshiro256plusScalar(state, out, n);
+  }
+}
+
+void philox4x32(const uint32_t (&counter)[4], const uint32_t (&key)[2], uint32_t (&out)[4][16]) noexcept {
+  switch (backend()) {
+#ifdef SIPM_DISPATCH_X86
+    case Backend::kAVX512:
+      philox4x32AVX512(counter, key, out);
+      return;
+    case Backend::kAVX2:
+      philox4x32AVX2(counter, key, out);
+      return;
+#endif
+    default:
+      philox4x32Scalar(counter, key, out);
+  }
+}
+
+void accumulate(float* __restrict__ y, const float* __restrict__ x, const float a, const uint32_t n) noexcept {
+  switch (backend()) {
+#ifdef SIPM_DISPATCH_X86
+    case Backend::kAVX512:
+      accumulateAVX512(y, x, a, n);
+      return;
+    case Backend::kAVX2:
+      accumulateAVX2(y, x, a, n);
+      return;
+#endif
+    default:
+      accumulateScalar(y, x, a, n);
+  }
+}
+} // namespace SiPMDispatch
+} // namespace sipm
@@ -0,0 +1,106 @@
+#include "SiPMFft.h"
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace sipm {
+SiPMFft::SiPMFft(const uint32_t n) : m_N(n) {
+  const uint32_t h = n / 2;
+  const double pi = std::acos(-1.0);
+
+  m_Twiddles.resize(h / 2);
+  for (uint32_t k = 0; k < h / 2; ++k) {
+    m_Twiddles[k] = std::polar(1.0, -2 * pi * k / h);
+  }
+  m_SplitTwiddles.resize(h);
+  for (uint32_t k = 0; k < h; ++k) {
+    m_SplitTwiddles[k] = std::polar(1.0, -2 * pi * k / n);
+  }
+
+  uint32_t bits = 0;
+  while ((1u << bits) < h) {
+    ++bits;
+  }
+  m_BitReverse.resize(h);
+  for (uint32_t i = 0; i < h; ++i) {
+    uint32_t r = 0;
+    for (uint32_t b = 0; b < bits; ++b) {
+      r |= ((i >> b) & 1) << (bits - 1 - b);
+    }
+    m_BitReverse[i] = r;
+  }
+}
+
+void SiPMFft::complexFft(std::complex<double>* data, const bool inverse) const noexcept {
+  const uint32_t h = m_N / 2;
+  for (uint32_t i = 0; i < h; ++i) {
+    const uint32_t j = m_BitReverse[i];
+    if (i < j) {
+      std::swap(data[i], data[j]);
+    }
+  }
+
+  for (uint32_t len = 2; len <= h; len <<= 1) {
+    const uint32_t half = len / 2;
+    const uint32_t step = h / len;
+    for (uint32_t i = 0; i < h; i += len) {
+      for (uint32_t j = 0; j < half; ++j) {
+        const std::complex<double> w = inverse ? std::conj(m_Twiddles[j * step]) : m_Twiddles[j * step];
+        const std::complex<double> u = data[i + j];
+        const std::complex<double> v = data[i + j + half] * w;
+        data[i + j] = u + v;
+        data[i + j + half] = u - v;
+      }
+    }
+  }
+}
+
+void SiPMFft::forward(const double* in, std::complex<double>* out) const noexcept {
+  const uint32_t h = m_N / 2;
+  // Even samples as real part, odd samples as imaginary part
+  for (uint32_t k = 0; k < h; ++k) {
+    out[k] = {in[2 * k], in[2 * k + 1]};
+  }
+  complexFft(out, false);
+
+  // Spectra of even (e) and odd (o) samples are recovered from the packed
+  // spectrum z, then X[k] = e[k] + W^k o[k]
+  const std::complex<double> z0 = out[0];
+  out[0] = {z0.real() + z0.imag(), 0};
+  out[h] = {z0.real() - z0.imag(), 0};
+  const std::complex<double> i(0, 1);
+  for (uint32_t k = 1; k <= h / 2; ++k) {
+    const std::complex<double> a = out[k];
+    const std::complex<double> b = out[h - k];
+    const std::complex<double> ek = 0.5 * (a + std::conj(b));
+    const std::complex<double> ok = -0.5 * i * (a - std::conj(b));
+    const std::complex<double> eh = 0.5 * (b + std::conj(a));
+    const std::complex<double> oh = -0.5 * i * (b - std::conj(a));
+    out[k] = ek + m_SplitTwiddles[k] * ok;
+    out[h - k] = eh + m_SplitTwiddles[h - k] * oh;
+  }
+}
+
+void SiPMFft::inverse(const std::complex<double>* in, double* out) const noexcept {
+  const uint32_t h = m_N / 2;
+  // Output buffer is used as complex array of size n / 2
+  std::complex<double>* z = reinterpret_cast<std::complex<double>*>(out);
+  const std::complex<double> i(0, 1);
+  for (uint32_t k = 0; k < h; ++k) {
+    const std::complex<double> a = in[k];
+    const std::complex<double> b = std::conj(in[h - k]);
+    const std::complex<double> ek = 0.5 * (a + b);
+    const std::complex<double> ok = 0.5 * (a - b) * std::conj(m_SplitTwiddles[k]);
+    z[k] = ek + i * ok;
+  }
+  complexFft(z, true);
+
+  const double scale = 1.0 / h;
+  for (uint32_t k = 0; k < m_N; ++k) {
+    out[k] *= scale;
+  }
+}
+} // namespace sipm
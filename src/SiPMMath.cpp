@@ -0,0 +1,105 @@
+#include "SiPMMath.h"
+#include "SiPMDispatch.h"
+
+#include <cstdint>
+#include <cstring>
+
+// Argument reductions and rounding tricks below rely on the order of floating
+// point operations, which -ffast-math would change. The guard is in the source
+// so that it applies to every build system.
+#if defined(__clang__)
+#pragma clang fp reassociate(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("no-associative-math", "no-reciprocal-math")
+#endif
+
+// Same condition used by SiPMDispatch for its AVX2 and AVX512 variants
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SIPM_MATH_X86
+#endif
+
+namespace sipm {
+namespace SiPMMath {
+namespace {
+// Kernels compiled for the target of the build
+namespace baseline {
+#if defined(__AVX512F__)
+constexpr int kVectorBytes = 64;
+#elif defined(__AVX2__)
+constexpr int kVectorBytes = 32;
+#else
+constexpr int kVectorBytes = 16;
+#endif
+#include "SiPMMathKernels.h"
+} // namespace baseline
+
+#ifdef SIPM_MATH_X86
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+namespace avx2 {
+constexpr int kVectorBytes = 32;
+#include "SiPMMathKernels.h"
+} // namespace avx2
+#if defined(__clang__)
+#pragma clang attribute pop
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#else
+#pragma GCC pop_options
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+namespace avx512 {
+constexpr int kVectorBytes = 64;
+#include "SiPMMathKernels.h"
+} // namespace avx512
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif
+
+struct Kernels {
+  void (*logF)(const float*, const uint32_t, float*) noexcept;
+  void (*expF)(const float*, const uint32_t, float*) noexcept;
+  void (*sincosF)(const float*, const uint32_t, float*, float*) noexcept;
+  void (*logD)(const double*, const uint32_t, double*) noexcept;
+  void (*expD)(const double*, const uint32_t, double*) noexcept;
+  void (*sincosD)(const double*, const uint32_t, double*, double*) noexcept;
+};
+
+// Indexed by SiPMDispatch::Backend, the baseline kernels are used where the
+// backend has no wider variant
+#define SIPM_MATH_KERNELS(ns) {ns::log, ns::exp, ns::sincos, ns::log, ns::exp, ns::sincos}
+#ifdef SIPM_MATH_X86
+const Kernels kKernels[] = {SIPM_MATH_KERNELS(baseline), SIPM_MATH_KERNELS(avx2), SIPM_MATH_KERNELS(avx512)};
+#else
+const Kernels kKernels[] = {SIPM_MATH_KERNELS(baseline), SIPM_MATH_KERNELS(baseline), SIPM_MATH_KERNELS(baseline)};
+#endif
+#undef SIPM_MATH_KERNELS
+
+// A baseline wider than the selected backend is faster and always supported
+inline const Kernels& kernels() noexcept {
+  const int backend = static_cast<int>(SiPMDispatch::backend());
+  const int minimum = baseline::kVectorBytes == 64 ? 2 : baseline::kVectorBytes == 32 ? 1 : 0;
+  return kKernels[backend > minimum ? backend : minimum];
+}
+} // namespace
+
+void log(const float* x, const uint32_t n, float* out) noexcept { kernels().logF(x, n, out); }
+
+void exp(const float* x, const uint32_t n, float* out) noexcept { kernels().expF(x, n, out); }
+
+void sincos(const float* x, const uint32_t n, float* s, float* c) noexcept { kernels().sincosF(x, n, s, c); }
+
+void log(const double* x, const uint32_t n, double* out) noexcept { kernels().logD(x, n, out); }
+
+void exp(const double* x, const uint32_t n, double* out) noexcept { kernels().expD(x, n, out); }
+
+void sincos(const double* x, const uint32_t n, double* s, double* c) noexcept { kernels().sincosD(x, n, s, c); }
+} // namespace SiPMMath
+} // namespace sipm
@@ -0,0 +1,261 @@
+// Kernels of SiPMMath, included by SiPMMath.cpp once for each target inside a
+// namespace that defines kVectorBytes. No include guard on purpose.
+
+typedef float VecF __attribute__((vector_size(kVectorBytes)));
+typedef int32_t VecI __attribute__((vector_size(kVectorBytes)));
+typedef double VecD __attribute__((vector_size(kVectorBytes)));
+typedef int64_t VecL __attribute__((vector_size(kVectorBytes)));
+typedef uint64_t VecU __attribute__((vector_size(kVectorBytes)));
+
+// Applies a kernel to n values, the last partial vector is padded with pad
+template <typename Vec, typename T, Vec (*kernel)(Vec)>
+inline void apply(const T* x, const uint32_t n, T* out, const T pad) noexcept {
+  constexpr uint32_t kLanes = sizeof(Vec) / sizeof(T);
+  uint32_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    Vec v;
+    std::memcpy(&v, x + i, sizeof(v));
+    v = kernel(v);
+    std::memcpy(out + i, &v, sizeof(v));
+  }
+  if (i < n) {
+    Vec v = Vec{} + pad;
+    std::memcpy(&v, x + i, (n - i) * sizeof(T));
+    v = kernel(v);
+    std::memcpy(out + i, &v, (n - i) * sizeof(T));
+  }
+}
+
+// Same as apply for kernels with two outputs
+template <typename Vec, typename T, void (*kernel)(Vec, Vec&, Vec&)>
+inline void apply2(const T* x, const uint32_t n, T* s, T* c) noexcept {
+  constexpr uint32_t kLanes = sizeof(Vec) / sizeof(T);
+  uint32_t i = 0;
+  Vec vs, vc;
+  for (; i + kLanes <= n; i += kLanes) {
+    Vec v;
+    std::memcpy(&v, x + i, sizeof(v));
+    kernel(v, vs, vc);
+    std::memcpy(s + i, &vs, sizeof(vs));
+    std::memcpy(c + i, &vc, sizeof(vc));
+  }
+  if (i < n) {
+    Vec v{};
+    std::memcpy(&v, x + i, (n - i) * sizeof(T));
+    kernel(v, vs, vc);
+    std::memcpy(s + i, &vs, (n - i) * sizeof(T));
+    std::memcpy(c + i, &vc, (n - i) * sizeof(T));
+  }
+}
+
+inline VecF broadcast(const float x) { return VecF{} + x; }
+inline VecD broadcast(const double x) { return VecD{} + x; }
+
+// Exact conversion of small integers to double: 0x1.8p52 + e has e in its
+// lowest bits
+inline VecD toDouble(const VecL e) {
+  return reinterpret_cast<VecD>(e + 0x4338000000000000) - 0x1.8p52;
+}
+
+/**
+ * Cephes logf: x = m * 2^e with m in [sqrt(0.5), sqrt(2)) and
+ * log(m) = f - f^2 / 2 + f^3 * P(f) with f = m - 1.
+ */
+inline VecF logKernel(const VecF x) {
+  const VecI bits = reinterpret_cast<VecI>(x);
+  VecI e = ((bits >> 23) & 0xff) - 126;
+  // m in [0.5, 1)
+  VecF m = reinterpret_cast<VecF>((bits & 0x7fffff) | 0x3f000000);
+  const VecI small = m < 0.707106781186547524f;
+  e += small;
+  m = small ? m + m : m;
+  const VecF f = m - 1;
+  const VecF z = f * f;
+  VecF p = broadcast(7.0376836292e-2f);
+  p = p * f - 1.1514610310e-1f;
+  p = p * f + 1.1676998740e-1f;
+  p = p * f - 1.2420140846e-1f;
+  p = p * f + 1.4249322787e-1f;
+  p = p * f - 1.6668057665e-1f;
+  p = p * f + 2.0000714765e-1f;
+  p = p * f - 2.4999993993e-1f;
+  p = p * f + 3.3333331174e-1f;
+  const VecF ef = __builtin_convertvector(e, VecF);
+  // log(2) = 0.693359375 - 2.12194440e-4, first term is exact when
+  // multiplied by the exponent
+  VecF y = p * f * z;
+  y = y + ef * -2.12194440e-4f;
+  y = y - 0.5f * z;
+  return (f + y) + ef * 0.693359375f;
+}
+
+/**
+ * Cephes expf: exp(x) = 2^n * exp(r) with n = round(x / log(2)) and
+ * exp(r) = 1 + r + r^2 * P(r).
+ */
+inline VecF expKernel(VecF x) {
+  // Results stay normal numbers, denormals would be flushed with -ffast-math
+  x = x > 88.0f ? broadcast(88.0f) : x;
+  x = x < -87.0f ? broadcast(-87.0f) : x;
+  // floor(x / log(2) + 0.5)
+  const VecF fx = x * 1.44269504088896341f + 0.5f;
+  VecI n = __builtin_convertvector(fx, VecI);
+  n += __builtin_convertvector(n, VecF) > fx;
+  const VecF nf = __builtin_convertvector(n, VecF);
+  x = x - nf * 0.693359375f;
+  x = x + nf * 2.12194440e-4f;
+  const VecF z = x * x;
+  VecF p = broadcast(1.9875691500e-4f);
+  p = p * x + 1.3981999507e-3f;
+  p = p * x + 8.3334519073e-3f;
+  p = p * x + 4.1665795894e-2f;
+  p = p * x + 1.6666665459e-1f;
+  p = p * x + 5.0000001201e-1f;
+  const VecF y = (p * z + x) + 1;
+  return y * reinterpret_cast<VecF>((n + 127) << 23);
+}
+
+/**
+ * Cephes sinf and cosf: x = j * pi / 4 + r with j even and |r| <= pi / 4,
+ * reduction uses pi / 4 split in three parts. Sine and cosine of r are
+ * swapped and their signs changed according to the octant.
+ */
+inline void sincosKernel(const VecF x, VecF& s, VecF& c) {
+  const VecI signX = reinterpret_cast<VecI>(x) & 0x80000000;
+  VecF ax = reinterpret_cast<VecF>(reinterpret_cast<VecI>(x) & 0x7fffffff);
+  VecI j = __builtin_convertvector(ax * 1.27323954473516f, VecI);
+  j = (j + 1) & ~1;
+  const VecF y = __builtin_convertvector(j, VecF);
+  ax = ax - y * 0.78515625f;
+  ax = ax - y * 2.4187564849853515625e-4f;
+  ax = ax - y * 3.77489497744594108e-8f;
+  const VecI signSin = signX ^ ((j & 4) << 29);
+  const VecI signCos = (~(j - 2) & 4) << 29;
+  const VecI swap = (j & 2) != 0;
+  const VecF z = ax * ax;
+  VecF pc = broadcast(2.443315711809948e-5f);
+  pc = pc * z - 1.388731625493765e-3f;
+  pc = pc * z + 4.166664568298827e-2f;
+  const VecF polyCos = (pc * z * z - 0.5f * z) + 1;
+  VecF ps = broadcast(-1.9515295891e-4f);
+  ps = ps * z + 8.3321608736e-3f;
+  ps = ps * z - 1.6666654611e-1f;
+  const VecF polySin = ps * z * ax + ax;
+  s = reinterpret_cast<VecF>(reinterpret_cast<VecI>(swap ? polyCos : polySin) ^ signSin);
+  c = reinterpret_cast<VecF>(reinterpret_cast<VecI>(swap ? polySin : polyCos) ^ signCos);
+}
+
+/**
+ * fdlibm log: x = m * 2^k with m in [sqrt(0.5), sqrt(2)), f = m - 1 and
+ * log(1 + f) = f - f^2 / 2 + s * (f^2 / 2 + R(s^2)) with s = f / (2 + f).
+ */
+inline VecD logKernel(const VecD x) {
+  const VecL bits = reinterpret_cast<VecL>(x);
+  // Logical shift, SSE2 has no arithmetic shift of 64 bits integers
+  VecL e = reinterpret_cast<VecL>(reinterpret_cast<VecU>(bits) >> 52) - 1022;
+  // m in [0.5, 1)
+  VecD m = reinterpret_cast<VecD>((bits & 0xfffffffffffff) | 0x3fe0000000000000);
+  const VecL small = m < 0.707106781186547524;
+  e += small;
+  m = small ? m + m : m;
+  const VecD f = m - 1;
+  const VecD s = f / (2 + f);
+  const VecD z = s * s;
+  VecD r = broadcast(1.479819860511658591e-01);
+  r = r * z + 1.531383769920937332e-01;
+  r = r * z + 1.818357216161805012e-01;
+  r = r * z + 2.222219843214978396e-01;
+  r = r * z + 2.857142874366239149e-01;
+  r = r * z + 3.999999999940941908e-01;
+  r = r * z + 6.666666666666735130e-01;
+  r = r * z;
+  const VecD hfsq = 0.5 * f * f;
+  const VecD k = toDouble(e);
+  // log(2) split in a part exact when multiplied by k and a correction
+  return k * 6.93147180369123816490e-01 - ((hfsq - (s * (hfsq + r) + k * 1.90821492927058770002e-10)) - f);
+}
+
+/**
+ * exp(x) = 2^n * exp(r) with n = round(x / log(2)) and exp(r) from its Taylor
+ * series up to r^13, enough for |r| <= log(2) / 2.
+ */
+inline VecD expKernel(VecD x) {
+  x = x > 709.0 ? broadcast(709.0) : x;
+  x = x < -708.0 ? broadcast(-708.0) : x;
+  // Rounding to integer by adding 0x1.8p52
+  const VecD t = x * 1.44269504088896340736 + 0x1.8p52;
+  const VecL n = reinterpret_cast<VecL>(t) - 0x4338000000000000;
+  const VecD nd = t - 0x1.8p52;
+  const VecD r = (x - nd * 6.93147180369123816490e-01) - nd * 1.90821492927058770002e-10;
+  // Terms from r^2 / 2! to r^13 / 13! with Estrin scheme, shorter dependency
+  // chain than Horner
+  const VecD r2 = r * r;
+  const VecD r4 = r2 * r2;
+  const VecD r8 = r4 * r4;
+  const VecD q01 = (1.0 / 6) * r + 0.5;
+  const VecD q23 = (1.0 / 120) * r + 1.0 / 24;
+  const VecD q45 = (1.0 / 5040) * r + 1.0 / 720;
+  const VecD q67 = (1.0 / 362880) * r + 1.0 / 40320;
+  const VecD q89 = (1.0 / 39916800) * r + 1.0 / 3628800;
+  const VecD q1011 = (1.0 / 6227020800) * r + 1.0 / 479001600;
+  const VecD q = (q01 + r2 * q23) + r4 * (q45 + r2 * q67) + r8 * (q89 + r2 * q1011);
+  const VecD y = (q * r2 + r) + 1;
+  return y * reinterpret_cast<VecD>((n + 1023) << 52);
+}
+
+/**
+ * fdlibm sin and cos: x = n * pi / 2 + r with |r| <= pi / 4, reduction uses
+ * pi / 2 split in three parts of 33 bits so that n * part is exact. Sine and
+ * cosine of r are swapped and their signs changed according to the quadrant.
+ */
+inline void sincosKernel(const VecD x, VecD& s, VecD& c) {
+  const VecD t = x * 6.36619772367581382433e-01 + 0x1.8p52;
+  const VecL n = reinterpret_cast<VecL>(t) - 0x4338000000000000;
+  const VecD nd = t - 0x1.8p52;
+  VecD r = x - nd * 1.57079632673412561417e+00;
+  r = r - nd * 6.07710050630396597660e-11;
+  r = r - nd * 2.02226624871116645580e-21;
+  const VecD z = r * r;
+  VecD ps = broadcast(1.58969099521155010221e-10);
+  ps = ps * z - 2.50507602534068634195e-08;
+  ps = ps * z + 2.75573137070700676789e-06;
+  ps = ps * z - 1.98412698298579493134e-04;
+  ps = ps * z + 8.33333333332248946124e-03;
+  ps = ps * z - 1.66666666666666324348e-01;
+  const VecD polySin = r + (z * r) * ps;
+  VecD pc = broadcast(-1.13596475577881948265e-11);
+  pc = pc * z + 2.08757232129817482790e-09;
+  pc = pc * z - 2.75573143513906633035e-07;
+  pc = pc * z + 2.48015872894767294178e-05;
+  pc = pc * z - 1.38888888888741095749e-03;
+  pc = pc * z + 4.16666666666666019037e-02;
+  const VecD hz = 0.5 * z;
+  const VecD w = 1 - hz;
+  // Rounding error of 1 - z / 2 added back
+  const VecD polyCos = w + (((1 - w) - hz) + z * z * pc);
+  // Selection with bitwise operations, SSE2 has no comparison of 64 bits
+  // integers
+  const VecL swap = -(n & 1);
+  const VecL bitsSin = reinterpret_cast<VecL>(polySin);
+  const VecL bitsCos = reinterpret_cast<VecL>(polyCos);
+  const VecL signSin = (n & 2) << 62;
+  const VecL signCos = ((n + 1) & 2) << 62;
+  s = reinterpret_cast<VecD>(((bitsSin & ~swap) | (bitsCos & swap)) ^ signSin);
+  c = reinterpret_cast<VecD>(((bitsCos & ~swap) | (bitsSin & swap)) ^ signCos);
+}
+
+void log(const float* x, const uint32_t n, float* out) noexcept { apply<VecF, float, logKernel>(x, n, out, 1.0f); }
+
+void exp(const float* x, const uint32_t n, float* out) noexcept { apply<VecF, float, expKernel>(x, n, out, 0.0f); }
+
+void sincos(const float* x, const uint32_t n, float* s, float* c) noexcept {
+  apply2<VecF, float, sincosKernel>(x, n, s, c);
+}
+
+void log(const double* x, const uint32_t n, double* out) noexcept { apply<VecD, double, logKernel>(x, n, out, 1.0); }
+
+void exp(const double* x, const uint32_t n, double* out) noexcept { apply<VecD, double, expKernel>(x, n, out, 0.0); }
+
+void sincos(const double* x, const uint32_t n, double* s, double* c) noexcept {
+  apply2<VecD, double, sincosKernel>(x, n, s, c);
+}
@@ -0,0 +1,1120 @@
+#include "SiPMModel.h"
+#include "SiPMAliasTable.h"
+#include "SiPMAnalogSignal.h"
+#include "SiPMDispatch.h"
+#include "SiPMEventContext.h"
+#include "SiPMFft.h"
+#include "SiPMHit.h"
+#include "SiPMProperties.h"
+#include "SiPMRandom.h"
+#include "SiPMTypes.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <ostream>
+#include <vector>
+
+namespace sipm {
+// All constructors MUST call signalShape
+SiPMModel::SiPMModel() {
+  signalShape();
+  pdeTable();
+  hitMapTable();
+  correlatedNoiseTables();
+}
+
+SiPMModel::SiPMModel(const SiPMProperties& aProperty) : m_Properties(aProperty) {
+  signalShape();
+  pdeTable();
+  hitMapTable();
+  correlatedNoiseTables();
+}
+
+void SiPMModel::beginEvent(SiPMEventContext& ctx) const {
+  // Counter-based engine restarts from the stream of this event
+  ctx.m_rng.setStream(ctx.m_EventId, ctx.m_ChannelId);
+  ++ctx.m_EventId;
+}
+
+void SiPMModel::runEvent(SiPMEventContext& ctx) const {
+  beginEvent(ctx);
+  // Electronic noise is generated in place in the signal of previous event
+  ctx.m_Signal.resize(m_Properties.nSignalPoints(), m_Properties.sampling());
+  generateNoise(ctx, ctx.m_Signal.data());
+  runEvent(ctx, ctx.m_Signal.data());
+}
+
+void SiPMModel::generateNoise(SiPMEventContext& ctx, float* signal) const {
+  const uint32_t nSignalPoints = m_Properties.nSignalPoints();
+  if (m_Properties.noiseMode() == SiPMProperties::NoiseMode::kBank) {
+    // Bank is extended by nSignalPoints so windows never wrap around
+    const uint32_t offset = ctx.m_rng.randInteger(m_NoiseBankSize);
+    std::copy_n(m_NoiseBank.data() + offset, nSignalPoints, signal);
+  } else {
+    ctx.m_rng.randGaussianF(0, m_Properties.snrLinear(), nSignalPoints, signal);
+  }
+}
+
+void SiPMModel::runEvent(SiPMEventContext& ctx, float* signal) const {
+  addDcrEvents(ctx);
+
+  addPhotoelectrons(ctx);
+
+  addCorrelatedNoise(ctx);
+  if (ctx.m_nTotalHits > 0) {
+    calculateSignalAmplitudes(ctx);
+    generateSignal(ctx, signal);
+  }
+}
+
+void SiPMModel::runEvents(SiPMEventContext& ctx, const double* times, const double* wavelengths,
+                          const uint32_t* offsets, const uint32_t nEvents, float* signals,
+                          SiPMDebugInfo* debugs) const {
+  const uint32_t nSignalPoints = m_Properties.nSignalPoints();
+
+  for (uint32_t i = 0; i < nEvents; ++i) {
+    ctx.resetState();
+    // Buffers keep their capacity so after few events no allocation is done
+    const uint32_t nPhotons = offsets[i + 1] - offsets[i];
+    ctx.addPhotons(times + offsets[i], wavelengths ? wavelengths + offsets[i] : nullptr, nPhotons);
+
+    beginEvent(ctx);
+    // Electronic noise is written directly in the output buffer
+    float* signal = signals + static_cast<size_t>(i) * nSignalPoints;
+    generateNoise(ctx, signal);
+    runEvent(ctx, signal);
+
+    if (debugs) {
+      debugs[i] = ctx.debug();
+    }
+  }
+}
+
+void SiPMModel::signalShape() {
+  const uint32_t nSignalPoints = m_Properties.nSignalPoints();
+  const float sampling = m_Properties.sampling();
+  const float tr = m_Properties.risingTime() / sampling;
+  const float tff = m_Properties.fallingTimeFast() / sampling;
+  const float gain = m_Properties.gain();
+
+  m_SignalShape = std::vector<float>(nSignalPoints, 0.0);
+  m_PulseWeights.clear();
+  m_PulseRates.clear();
+  m_PulsePhases.clear();
+
+  if (m_Properties.hasPulseTemplate()) {
+    // Measured pulses can not be described by exponentials, recursive engine
+    // is not available
+    pulseTemplateBank();
+  } else {
+    if (m_Properties.hasSlowComponent()) {
+      const float tfs = m_Properties.fallingTimeSlow() / sampling;
+      const float slf = m_Properties.slowComponentFraction();
+
+      for (uint32_t i = 0; i < nSignalPoints; ++i) {
+        m_SignalShape[i] = (1 - slf) * exp(-(float)i / tff) + slf * exp(-(float)i / tfs) - exp(-(float)i / tr);
+      }
+    } else {
+      for (uint32_t i = 0; i < nSignalPoints; ++i) {
+        m_SignalShape[i] = exp(-(float)i / tff) - exp(-(float)i / tr);
+      }
+    }
+
+    const float peak = *std::max_element(m_SignalShape.begin(), m_SignalShape.end());
+
+    for (uint32_t i = 0; i < nSignalPoints; ++i) {
+      m_SignalShape[i] = m_SignalShape[i] / peak * gain;
+    }
+
+    // Same shape as a sum of exponentials, used by recursive engine
+    if (m_Properties.hasSlowComponent()) {
+      const float slf = m_Properties.slowComponentFraction();
+      m_PulseWeights = {(1 - slf) / peak * gain, slf / peak * gain, -1 / peak * gain};
+      m_PulseRates = {1 / tff, sampling / m_Properties.fallingTimeSlow(), 1 / tr};
+    } else {
+      m_PulseWeights = {1 / peak * gain, -1 / peak * gain};
+      m_PulseRates = {1 / tff, 1 / tr};
+    }
+  }
+
+  // Plan and shape spectrum used by FFT engine. Size is at least twice the
+  // signal length so circular convolution does not wrap around.
+  if (nSignalPoints > 0) {
+    m_Fft = SiPMFft(SiPMFft::nextPow2(2 * nSignalPoints));
+    std::vector<double> padded(m_Fft.size(), 0);
+    std::copy(m_SignalShape.begin(), m_SignalShape.end(), padded.begin());
+    m_ShapeSpectrum.resize(m_Fft.nBins());
+    m_Fft.forward(padded.data(), m_ShapeSpectrum.data());
+    // Direct engine costs ~hits * points, FFT engine ~M * log2(M)
+    m_FftMinHits = kFftCost * m_Fft.size() * std::log2(m_Fft.size()) / nSignalPoints;
+  }
+
+  m_NoiseBank.clear();
+  m_NoiseBankSize = 0;
+  if (m_Properties.noiseMode() == SiPMProperties::NoiseMode::kBank && nSignalPoints > 0) {
+    noiseBank();
+  }
+}
+
+void SiPMModel::noiseBank() {
+  const uint32_t nSignalPoints = m_Properties.nSignalPoints();
+  const uint32_t n = SiPMFft::nextPow2(std::max(m_Properties.noiseBankSize(), 2 * nSignalPoints));
+  const std::map<double, double>& spectrum = m_Properties.noiseSpectrum();
+
+  // Same bank for all models with the same properties
+  SiPMRandom rng;
+  rng.seed(kNoiseBankSeed);
+  std::vector<double> noise = rng.randGaussian(0, 1, n);
+
+  if (!spectrum.empty()) {
+    // White noise is colored in frequency domain by the square root of the
+    // power spectrum, linearly interpolated on the bins of the bank.
+    // Periodic FFT keeps the ring buffer continuous at the wrap point.
+    const SiPMFft fft(n);
+    std::vector<std::complex<double>> bins(fft.nBins());
+    fft.forward(noise.data(), bins.data());
+    const double df = 1 / (n * m_Properties.sampling());
+    for (uint32_t k = 0; k < bins.size(); ++k) {
+      const double f = k * df;
+      double power;
+      auto it1 = spectrum.upper_bound(f);
+      if (it1 == spectrum.begin()) {
+        power = it1->second;
+      } else if (it1 == spectrum.end()) {
+        power = spectrum.rbegin()->second;
+      } else {
+        auto it0 = std::prev(it1);
+        power = it0->second + (it1->second - it0->second) * (f - it0->first) / (it1->first - it0->first);
+      }
+      bins[k] *= std::sqrt(std::max(power, 0.0));
+    }
+    fft.inverse(bins.data(), noise.data());
+  }
+
+  // Noise RMS is always given by the SNR
+  double mean = 0;
+  double var = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    mean += noise[i];
+  }
+  mean /= n;
+  for (uint32_t i = 0; i < n; ++i) {
+    var += (noise[i] - mean) * (noise[i] - mean);
+  }
+  var /= n;
+  const double scale = var > 0 ? m_Properties.snrLinear() / std::sqrt(var) : 0;
+
+  m_NoiseBankSize = n;
+  m_NoiseBank.resize(static_cast<size_t>(n) + nSignalPoints);
+  for (uint32_t i = 0; i < n; ++i) {
+    m_NoiseBank[i] = (noise[i] - mean) * scale;
+  }
+  std::copy_n(m_NoiseBank.begin(), nSignalPoints, m_NoiseBank.begin() + n);
+}
+
+void SiPMModel::pulseTemplateBank() {
+  const uint32_t nSignalPoints = m_Properties.nSignalPoints();
+  const uint32_t nPhases = m_Properties.pulsePhases();
+  const std::vector<double>& pulse = m_Properties.pulseTemplate();
+  const double samplingRatio = m_Properties.sampling() / m_Properties.pulseTemplateSampling();
+  const double peak = *std::max_element(pulse.begin(), pulse.end());
+  const double gain = m_Properties.gain();
+
+  // Linear interpolation of the template, t in template samples
+  auto interpolate = [&pulse](const double t) -> double {
+    if (t < 0 || t > pulse.size() - 1) {
+      return 0;
+    }
+    const uint32_t i = static_cast<uint32_t>(t);
+    if (i == pulse.size() - 1) {
+      return pulse.back();
+    }
+    const double f = t - i;
+    return pulse[i] * (1 - f) + pulse[i + 1] * f;
+  };
+
+  // Phase p holds the pulse of a hit delayed by p / nPhases samples with
+  // respect to the sampling point where it is added
+  m_PulsePhases.resize(static_cast<size_t>(nPhases) * nSignalPoints);
+  for (uint32_t p = 0; p < nPhases; ++p) {
+    const double delay = static_cast<double>(p) / nPhases;
+    float* phase = m_PulsePhases.data() + static_cast<size_t>(p) * nSignalPoints;
+    for (uint32_t i = 0; i < nSignalPoints; ++i) {
+      phase[i] = interpolate((i - delay) * samplingRatio) / peak * gain;
+    }
+  }
+  // Phase 0 is also the signal shape seen by the other engines
+  std::copy(m_PulsePhases.begin(), m_PulsePhases.begin() + nSignalPoints, m_SignalShape.begin());
+}
+
+void SiPMModel::pdeTable() {
+  // Spectrum is stored on a uniform grid with slope and intercept of each
+  // bin, so evaluating the PDE needs no search
+  const std::map<double, double>& pde = m_Properties.pdeSpectrum();
+  m_PdeSlope.clear();
+  m_PdeIntercept.clear();
+  if (pde.size() < 2) {
+    m_PdeMin = 0;
+    m_PdeRecStep = 0;
+    m_PdeSlope = {0};
+    m_PdeIntercept = {pde.empty() ? 0 : pde.begin()->second};
+    return;
+  }
+
+  // Linear interpolation of the spectrum stored in m_Properties, extrapolated
+  // using first and last bin
+  auto interpolate = [&pde](const double x) -> double {
+    auto it1 = pde.upper_bound(x);
+    if (it1 == pde.end()) {
+      --it1;
+    }
+    if (it1 == pde.begin()) {
+      ++it1;
+    }
+    auto it0 = std::prev(it1);
+    const double m = (it1->second - it0->second) / (it1->first - it0->first);
+    return it0->second + m * (x - it0->first);
+  };
+
+  const uint32_t nBins = pde.size() - 1;
+  const double xmin = pde.begin()->first;
+  const double step = (pde.rbegin()->first - xmin) / nBins;
+  m_PdeMin = xmin;
+  m_PdeRecStep = 1 / step;
+  m_PdeSlope.resize(nBins);
+  m_PdeIntercept.resize(nBins);
+  for (uint32_t i = 0; i < nBins; ++i) {
+    const double x0 = xmin + i * step;
+    const double x1 = xmin + (i + 1) * step;
+    const double y0 = interpolate(x0);
+    const double y1 = interpolate(x1);
+    m_PdeSlope[i] = (y1 - y0) / (x1 - x0);
+    m_PdeIntercept[i] = y0 - m_PdeSlope[i] * x0;
+  }
+}
+
+void SiPMModel::hitMapTable() {
+  const uint32_t nSideCells = m_Properties.nSideCells();
+  std::vector<double> weights;
+  switch (m_Properties.hitDistribution()) {
+    case SiPMProperties::HitDistribution::kCircle: {
+      // 90% of photons uniform in the circle inscribed in the sensor and 10%
+      // outside. Fraction of each cell inside the circle is estimated on a
+      // sub-grid of kSub x kSub points
+      constexpr uint32_t kSub = 4;
+      std::vector<double> inside(m_Properties.nCells());
+      double sumIn = 0;
+      for (uint32_t r = 0; r < nSideCells; ++r) {
+        for (uint32_t c = 0; c < nSideCells; ++c) {
+          uint32_t nIn = 0;
+          for (uint32_t i = 0; i < kSub; ++i) {
+            for (uint32_t j = 0; j < kSub; ++j) {
+              const double x = 2 * (r + (i + 0.5) / kSub) / nSideCells - 1;
+              const double y = 2 * (c + (j + 0.5) / kSub) / nSideCells - 1;
+              nIn += x * x + y * y <= 1;
+            }
+          }
+          inside[r * nSideCells + c] = static_cast<double>(nIn) / (kSub * kSub);
+          sumIn += inside[r * nSideCells + c];
+        }
+      }
+      const double sumOut = m_Properties.nCells() - sumIn;
+      weights.resize(m_Properties.nCells());
+      for (uint32_t i = 0; i < weights.size(); ++i) {
+        weights[i] = 0.9 * inside[i] / sumIn + (sumOut > 0 ? 0.1 * (1 - inside[i]) / sumOut : 0);
+      }
+      break;
+    }
+    case SiPMProperties::HitDistribution::kCustomMap: {
+      // Each cell takes the intensity of the map bin containing its center
+      const std::vector<double>& map = m_Properties.hitMap();
+      const uint32_t nRows = m_Properties.hitMapRows();
+      const uint32_t nCols = m_Properties.hitMapCols();
+      weights.assign(m_Properties.nCells(), 0);
+      // Without a valid map all weights are 0 and hits are uniform
+      if (nRows == 0 || nCols == 0 || map.size() != static_cast<size_t>(nRows) * nCols) {
+        break;
+      }
+      for (uint32_t r = 0; r < nSideCells; ++r) {
+        const uint32_t row = (r + 0.5) * nRows / nSideCells;
+        for (uint32_t c = 0; c < nSideCells; ++c) {
+          const uint32_t col = (c + 0.5) * nCols / nSideCells;
+          weights[r * nSideCells + c] = std::max(map[row * nCols + col], 0.0);
+        }
+      }
+      break;
+    }
+    default:
+      m_HitTable = SiPMAliasTable();
+      return;
+  }
+  m_HitTable = SiPMAliasTable(weights);
+}
+
+double SiPMModel::evaluatePde(const double x) const {
+  // Linear interpolation of x (wlen) to obtain a new value
+  // for y (pde) using the LUT built in pdeTable
+  const int32_t last = m_PdeSlope.size() - 1;
+  const int32_t bin = std::min(std::max(static_cast<int32_t>(std::floor((x - m_PdeMin) * m_PdeRecStep)), 0), last);
+  const double newy = m_PdeSlope[bin] * x + m_PdeIntercept[bin];
+  return (newy < 0) ? 0 : newy;
+}
+
+/**
+ * Same as @ref evaluatePde for n wavelengths at once. The loop has no
+ * branches so it can be vectorized.
+ */
+void SiPMModel::evaluatePde(const double* __restrict__ x, const uint32_t n, double* __restrict__ out) const noexcept {
+  const double* __restrict__ slope = m_PdeSlope.data();
+  const double* __restrict__ intercept = m_PdeIntercept.data();
+  const double xmin = m_PdeMin;
+  const double recStep = m_PdeRecStep;
+  const int32_t last = m_PdeSlope.size() - 1;
+  for (uint32_t i = 0; i < n; ++i) {
+    // Signed conversion and clamping on integers can be vectorized
+    const int32_t bin = std::min(std::max(static_cast<int32_t>(std::floor((x[i] - xmin) * recStep)), 0), last);
+    const double y = slope[bin] * x[i] + intercept[bin];
+    out[i] = y < 0 ? 0 : y;
+  }
+}
+
+pair<uint32_t> SiPMModel::hitUniform(SiPMRandom& rng) const {
+  return rng.randInteger2(m_Properties.nSideCells());
+}
+
+pair<uint32_t> SiPMModel::hitMap(SiPMRandom& rng) const {
+  const uint32_t nSideCells = m_Properties.nSideCells();
+  const uint32_t cell = m_HitTable.sample(rng);
+  return {cell / nSideCells, cell % nSideCells};
+}
+
+pair<uint32_t> SiPMModel::hitGaussian(SiPMRandom& rng) const {
+  pair<uint32_t> hit;
+  const double x = rng.randGaussian(0, 1);
+  const double y = rng.randGaussian(0, 1);
+
+  if (std::abs(x) < 1.64 && std::abs(y) < 1.64) { // 95% of samples = 1.64 sigmas
+    hit.first = (x + 1.64) * (m_Properties.nSideCells() / 3.28);
+    hit.second = (y + 1.64) * (m_Properties.nSideCells() / 3.28);
+  } else {
+    hit = hitUniform(rng);
+  }
+  return hit;
+}
+
+pair<uint32_t> SiPMModel::hitCell(SiPMRandom& rng) const {
+  switch (m_Properties.hitDistribution()) {
+  case SiPMProperties::HitDistribution::kUniform:
+    return hitUniform(rng);
+  case SiPMProperties::HitDistribution::kCircle:
+  case SiPMProperties::HitDistribution::kCustomMap:
+    return hitMap(rng);
+  case SiPMProperties::HitDistribution::kGaussian:
+    return hitGaussian(rng);
+  }
+  return hitUniform(rng);
+}
+
+/**
+ * Bulk version of @ref hitCell: distribution is selected once for all the
+ * hits, uniform hits are generated in two bulk calls and the alias table is
+ * sampled in bulk.
+ */
+void SiPMModel::hitCells(SiPMRandom& rng, const uint32_t n, uint32_t* rows, uint32_t* cols) const {
+  switch (m_Properties.hitDistribution()) {
+    case SiPMProperties::HitDistribution::kUniform:
+      rng.randInteger(m_Properties.nSideCells(), n, rows);
+      rng.randInteger(m_Properties.nSideCells(), n, cols);
+      return;
+    case SiPMProperties::HitDistribution::kCircle:
+    case SiPMProperties::HitDistribution::kCustomMap: {
+      const uint32_t nSideCells = m_Properties.nSideCells();
+      m_HitTable.sample(rng, n, rows);
+      for (uint32_t i = 0; i < n; ++i) {
+        cols[i] = rows[i] % nSideCells;
+        rows[i] = rows[i] / nSideCells;
+      }
+      return;
+    }
+    case SiPMProperties::HitDistribution::kGaussian:
+      for (uint32_t i = 0; i < n; ++i) {
+        const pair<uint32_t> hit = hitGaussian(rng);
+        rows[i] = hit.first;
+        cols[i] = hit.second;
+      }
+      return;
+  }
+}
+
+/**
+ * Quantizes positions of photons idx[0..n) (in mm, origin in the center of
+ * the sensor) to cells: rows follow y and columns follow x. Photons outside of
+ * the sensor get row and column equal to nSideCells. The loop has no branches
+ * so it can be vectorized using gathers.
+ */
+void SiPMModel::positionCells(const float* __restrict__ x, const float* __restrict__ y,
+                              const uint32_t* __restrict__ idx, const uint32_t n, uint32_t* __restrict__ rows,
+                              uint32_t* __restrict__ cols) const noexcept {
+  const uint32_t nSideCells = m_Properties.nSideCells();
+  const float side = nSideCells;
+  const float recPitch = 1000.0f / m_Properties.pitch();
+  // Cells cover nSideCells * pitch, centered on the sensor
+  const float half = 0.5f * side;
+  for (uint32_t i = 0; i < n; ++i) {
+    const float u = x[idx[i]] * recPitch + half;
+    const float v = y[idx[i]] * recPitch + half;
+    const bool inside = (u >= 0) & (u < side) & (v >= 0) & (v < side);
+    cols[i] = inside ? static_cast<int32_t>(u) : nSideCells;
+    rows[i] = inside ? static_cast<int32_t>(v) : nSideCells;
+  }
+}
+
+/**
+ * Dark counts are a Poisson process: the number of dark counts in the signal
+ * window is sampled first and then their times and cells are generated in
+ * bulk, uniformly in the window and on the sensor.
+ */
+void SiPMModel::addDcrEvents(SiPMEventContext& ctx) const {
+  if (m_Properties.hasDcr() == false) {
+    return;
+  }
+  const double signalLength = m_Properties.signalLength();
+  const uint32_t nSideCells = m_Properties.nSideCells();
+  SiPMRandom& rng = ctx.m_rng;
+
+  const uint32_t n = rng.randPoisson(m_Properties.dcr() * signalLength * 1e-9);
+  if (n == 0) {
+    return;
+  }
+  ctx.m_HitTimes.resize(n);
+  ctx.m_CellRows.resize(n);
+  ctx.m_CellCols.resize(n);
+  double* times = ctx.m_HitTimes.data();
+  rng.Rand(n, times);
+  for (uint32_t i = 0; i < n; ++i) {
+    times[i] *= signalLength;
+  }
+  // DCR are uniform on sipm surface
+  rng.randInteger(nSideCells, n, ctx.m_CellRows.data());
+  rng.randInteger(nSideCells, n, ctx.m_CellCols.data());
+
+  // DCR has no parent
+  ctx.m_Hits.add(n, times, ctx.m_CellRows.data(), ctx.m_CellCols.data(), SiPMHit::HitType::kDarkCount);
+  ctx.m_nTotalHits += n;
+  ctx.m_nDcr += n;
+  ctx.m_nPe += n;
+}
+
+void SiPMModel::addPhotoelectrons(SiPMEventContext& ctx) const {
+  const double sigLen = m_Properties.signalLength();
+  const double* photonTimes = ctx.m_PhotonTimes.data();
+  const uint32_t nPhotons = ctx.m_PhotonTimes.size();
+  constexpr SiPMHit::HitType photoelectron = SiPMHit::HitType::kPhotoelectron;
+  SiPMRandom& rng = ctx.m_rng;
+  SiPMHitStore& hits = ctx.m_Hits;
+
+  // Indices of photons that become photoelectrons. Compaction is branch-free:
+  // the index is always written and the counter moves only if accepted.
+  ctx.m_AcceptedPhotons.resize(nPhotons);
+  uint32_t* accepted = ctx.m_AcceptedPhotons.data();
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < nPhotons; ++i) {
+    accepted[n] = i;
+    n += (photonTimes[i] >= 0) & (photonTimes[i] <= sigLen);
+  }
+
+  // PDE applied to photons in the signal window
+  switch (m_Properties.pdeType()) {
+    case SiPMProperties::PdeType::kNoPde:
+      break;
+    case SiPMProperties::PdeType::kSimplePde: {
+      if (m_Properties.pdeSampling() == SiPMProperties::PdeSampling::kBinomial) {
+        // Number of detected photons first, then which ones
+        const uint32_t nDetected = rng.randBinomial(n, m_Properties.pde());
+        ctx.m_SelectedMask.resize((n + 63) / 64);
+        rng.randSubset(n, nDetected, ctx.m_SelectedMask.data());
+        uint32_t nAccepted = 0;
+        for (uint32_t w = 0; w < ctx.m_SelectedMask.size(); ++w) {
+          uint64_t bits = ctx.m_SelectedMask[w];
+          while (bits) {
+            accepted[nAccepted++] = accepted[64 * w + __builtin_ctzll(bits)];
+            bits &= bits - 1;
+          }
+        }
+        n = nAccepted;
+        break;
+      }
+      ctx.m_Uniforms.resize(n);
+      const float* u = ctx.m_Uniforms.data();
+      rng.RandF(n, ctx.m_Uniforms.data());
+      const float pde = m_Properties.pde();
+      uint32_t nAccepted = 0;
+      for (uint32_t i = 0; i < n; ++i) {
+        accepted[nAccepted] = accepted[i];
+        nAccepted += u[i] < pde;
+      }
+      n = nAccepted;
+      break;
+    }
+    case SiPMProperties::PdeType::kSpectrumPde: {
+      // PDE of all photons evaluated in a single pass
+      ctx.m_PdeValues.resize(nPhotons);
+      evaluatePde(ctx.m_PhotonWavelengths.data(), nPhotons, ctx.m_PdeValues.data());
+      const double* pde = ctx.m_PdeValues.data();
+      ctx.m_Uniforms.resize(n);
+      const float* u = ctx.m_Uniforms.data();
+      rng.RandF(n, ctx.m_Uniforms.data());
+      uint32_t nAccepted = 0;
+      for (uint32_t i = 0; i < n; ++i) {
+        const uint32_t idx = accepted[i];
+        accepted[nAccepted] = idx;
+        nAccepted += u[i] < pde[idx];
+      }
+      n = nAccepted;
+      break;
+    }
+  }
+
+  // Cells of all photoelectrons
+  ctx.m_CellRows.resize(n);
+  ctx.m_CellCols.resize(n);
+  uint32_t* rows = ctx.m_CellRows.data();
+  uint32_t* cols = ctx.m_CellCols.data();
+  if (ctx.hasPhotonPositions()) {
+    // Detection does not depend on the position so photons outside of the
+    // sensor are removed only after PDE, quantizing fewer positions
+    positionCells(ctx.m_PhotonX.data(), ctx.m_PhotonY.data(), accepted, n, rows, cols);
+    const uint32_t nSideCells = m_Properties.nSideCells();
+    uint32_t nInside = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+      accepted[nInside] = accepted[i];
+      rows[nInside] = rows[i];
+      cols[nInside] = cols[i];
+      nInside += rows[i] < nSideCells;
+    }
+    n = nInside;
+  } else {
+    hitCells(rng, n, rows, cols);
+  }
+
+  hits.reserve(hits.size() + n);
+  for (uint32_t i = 0; i < n; ++i) {
+    hits.add(photonTimes[accepted[i]], 1, ctx.m_CellRows[i], ctx.m_CellCols[i], photoelectron);
+  }
+  ctx.m_nTotalHits += n;
+  ctx.m_nPe += n;
+}
+
+namespace {
+// Valid neighbours of a cell for each position of the cell on the sensor.
+// Position along rows and columns is a 2 bits mask: bit 0 if the cell is on
+// the first row (column) and bit 1 if it is on the last one, so the table has
+// an entry for each of the 16 combinations.
+struct NeighbourTable {
+  uint32_t count[16];
+  int32_t row[16][8];
+  int32_t col[16][8];
+};
+
+constexpr NeighbourTable makeNeighbourTable() {
+  NeighbourTable table{};
+  for (uint32_t pos = 0; pos < 16; ++pos) {
+    const uint32_t posRow = pos >> 2;
+    const uint32_t posCol = pos & 3;
+    uint32_t n = 0;
+    for (int32_t dr = -1; dr <= 1; ++dr) {
+      for (int32_t dc = -1; dc <= 1; ++dc) {
+        const bool outside = (dr == -1 && (posRow & 1)) || (dr == 1 && (posRow & 2)) ||
+                             (dc == -1 && (posCol & 1)) || (dc == 1 && (posCol & 2));
+        if ((dr == 0 && dc == 0) || outside) {
+          continue;
+        }
+        table.row[pos][n] = dr;
+        table.col[pos][n] = dc;
+        ++n;
+      }
+    }
+    table.count[pos] = n;
+  }
+  return table;
+}
+
+constexpr NeighbourTable kNeighbours = makeNeighbourTable();
+
+// Number of events of a Poisson distribution by sequential search of its CDF.
+// Mean is small so the search usually ends at the first or second entry
+inline uint32_t poissonCount(const std::vector<double>& cdf, const double u) noexcept {
+  const uint32_t n = cdf.size();
+  uint32_t k = 0;
+  while (k < n && u >= cdf[k]) {
+    ++k;
+  }
+  return k;
+}
+} // namespace
+
+void SiPMModel::correlatedNoiseTables() {
+  // CDF of the number of children of each hit, up to a tail below 1e-16
+  auto poissonCdf = [](const double mu) {
+    std::vector<double> cdf;
+    if (mu <= 0) {
+      return cdf;
+    }
+    double pmf = std::exp(-mu);
+    double sum = pmf;
+    for (uint32_t k = 1; 1 - sum > 1e-16 && k < 64; ++k) {
+      cdf.push_back(sum);
+      pmf *= mu / k;
+      sum += pmf;
+    }
+    cdf.push_back(sum);
+    return cdf;
+  };
+  m_XtCdf = m_Properties.hasXt() ? poissonCdf(m_Properties.xt()) : std::vector<double>();
+  m_ApCdf = m_Properties.hasAp() ? poissonCdf(m_Properties.ap()) : std::vector<double>();
+}
+
+/**
+ * Correlated noise is a branching process: each hit generates a Poisson
+ * number of crosstalk and afterpulse hits, which can generate other hits and
+ * so on. Hits are processed one generation at a time: the number of children
+ * of all the hits of a generation is drawn in bulk and then all the children
+ * are added, becoming the next generation.
+ * Crosstalk hits are placed in one of the valid neighbours of the parent cell
+ * using @ref kNeighbours and delays are drawn with
+ * SiPMRandom::randExponentialTrunc truncated at the end of the signal, so no
+ * random value is rejected.
+ */
+void SiPMModel::addCorrelatedNoise(SiPMEventContext& ctx) const {
+  if (!m_Properties.hasXt() && !m_Properties.hasAp()) {
+    return;
+  }
+  SiPMRandom& rng = ctx.m_rng;
+  SiPMHitStore& hits = ctx.m_Hits;
+  const uint32_t lastCell = m_Properties.nSideCells() - 1;
+  const double signalLength = m_Properties.signalLength();
+  const bool hasDXt = m_Properties.hasDXt();
+  const float dxt = m_Properties.dxt();
+  const double dxtTau = m_Properties.dxtTau();
+  const float apSlowFraction = m_Properties.apSlowFraction();
+  const double tauApFast = m_Properties.tauApFast();
+  const double tauApSlow = m_Properties.tauApSlow();
+  std::vector<uint32_t>& xtParents = ctx.m_XtParents;
+  std::vector<uint32_t>& apParents = ctx.m_ApParents;
+
+  uint32_t begin = 0;
+  uint32_t end = ctx.m_nTotalHits;
+  while (begin < end) {
+    // Number of children of each hit in current generation
+    const uint32_t nParents = end - begin;
+    ctx.m_CascadeUniforms.resize(2 * nParents);
+    const double* uCount = ctx.m_CascadeUniforms.data();
+    rng.Rand(2 * nParents, ctx.m_CascadeUniforms.data());
+    xtParents.clear();
+    apParents.clear();
+    for (uint32_t i = 0; i < nParents; ++i) {
+      const uint32_t nXt = poissonCount(m_XtCdf, uCount[i]);
+      const uint32_t nAp = poissonCount(m_ApCdf, uCount[nParents + i]);
+      xtParents.insert(xtParents.end(), nXt, begin + i);
+      apParents.insert(apParents.end(), nAp, begin + i);
+    }
+    const uint32_t nXt = xtParents.size();
+    const uint32_t nAp = apParents.size();
+    hits.reserve(end + nXt + nAp);
+
+    // Uniforms for neighbour and delayed flag of xt and slow flag of ap
+    ctx.m_Uniforms.resize(2 * nXt + nAp);
+    rng.RandF(2 * nXt + nAp, ctx.m_Uniforms.data());
+    const float* u = ctx.m_Uniforms.data();
+
+    // Delays of delayed xt and ap, truncated at the end of the signal
+    std::vector<double>& delays = ctx.m_Delays;
+    std::vector<double>& delayMax = ctx.m_DelayMax;
+    delays.clear();
+    delayMax.clear();
+    for (uint32_t i = 0; i < nXt; ++i) {
+      if (hasDXt && (u[nXt + i] < dxt)) {
+        delays.push_back(dxtTau);
+        delayMax.push_back(signalLength - hits.time(xtParents[i]));
+      }
+    }
+    for (uint32_t i = 0; i < nAp; ++i) {
+      delays.push_back(u[2 * nXt + i] < apSlowFraction ? tauApSlow : tauApFast);
+      delayMax.push_back(signalLength - hits.time(apParents[i]));
+    }
+    rng.randExponentialTrunc(delays.data(), delayMax.data(), delays.size(), delays.data());
+    const double* delay = delays.data();
+
+    // XT
+    for (uint32_t i = 0; i < nXt; ++i) {
+      const uint32_t parent = xtParents[i];
+      const uint32_t row = hits.row(parent);
+      const uint32_t col = hits.col(parent);
+      const uint32_t pos = ((row == 0) | ((row == lastCell) << 1)) << 2 | (col == 0) | ((col == lastCell) << 1);
+      const uint32_t nNeighbours = kNeighbours.count[pos];
+      const bool isDelayed = hasDXt && (u[nXt + i] < dxt);
+      const double time = isDelayed ? hits.time(parent) + *delay++ : hits.time(parent);
+      // Sensor with a single cell
+      if (nNeighbours == 0) {
+        continue;
+      }
+      const uint32_t k = u[i] * nNeighbours;
+      const SiPMHit::HitType hitType =
+        isDelayed ? SiPMHit::HitType::kDelayedOpticalCrosstalk : SiPMHit::HitType::kOpticalCrosstalk;
+      hits.add(time, 1, row + kNeighbours.row[pos][k], col + kNeighbours.col[pos][k], hitType, parent);
+      ctx.m_nTotalHits++;
+      ctx.m_nXt++;
+      ctx.m_nPe++;
+      // Increase only if is delayed xt
+      ctx.m_nDXt += isDelayed;
+    }
+
+    // AP
+    for (uint32_t i = 0; i < nAp; ++i) {
+      const uint32_t parent = apParents[i];
+      const bool isSlow = u[2 * nXt + i] < apSlowFraction;
+      const SiPMHit::HitType hitType = isSlow ? SiPMHit::HitType::kSlowAfterPulse : SiPMHit::HitType::kFastAfterPulse;
+      hits.add(hits.time(parent) + *delay++, 1, hits.row(parent), hits.col(parent), hitType, parent);
+      ctx.m_nTotalHits++;
+      ctx.m_nAp++;
+    }
+
+    begin = end;
+    end = ctx.m_nTotalHits;
+  }
+}
+
+uint32_t SiPMModel::nextGeneration(SiPMEventContext& ctx) const {
+  const uint32_t nCells = m_Properties.nCells();
+  // Per-cell arrays are allocated once for each sensor size
+  if (ctx.m_CellStamp.size() != nCells) {
+    ctx.m_CellStamp.assign(nCells, 0);
+    ctx.m_Generation = 0;
+  }
+  // Stamp 0 is never used so a fresh array has no occupied cells
+  if (++ctx.m_Generation == 0) {
+    std::fill(ctx.m_CellStamp.begin(), ctx.m_CellStamp.end(), 0);
+    ctx.m_Generation = 1;
+  }
+  return ctx.m_Generation;
+}
+
+void SiPMModel::calculateSignalAmplitudes(SiPMEventContext& ctx) const {
+  const uint32_t nTotalHits = ctx.m_nTotalHits;
+  const float ccgv = m_Properties.ccgv();
+  float* amplitudes = ctx.m_Hits.amplitudes().data();
+
+  // Add ccgv to all hits
+  ctx.m_Gains.resize(nTotalHits);
+  const float* gains = ctx.m_Gains.data();
+  ctx.m_rng.randGaussianF(1, ccgv, nTotalHits, ctx.m_Gains.data());
+  for (uint32_t i = 0; i < nTotalHits; ++i) {
+    amplitudes[i] *= gains[i];
+  }
+
+  switch (m_Properties.recoveryMode()) {
+    case SiPMProperties::RecoveryMode::kPerCell:
+      recoveryPerCell(ctx);
+      return;
+    case SiPMProperties::RecoveryMode::kTimeSorted:
+      recoveryTimeSorted(ctx);
+      return;
+  }
+}
+
+void SiPMModel::recoveryPerCell(SiPMEventContext& ctx) const {
+  static constexpr uint32_t kNoHit = UINT32_MAX;
+  const uint32_t nTotalHits = ctx.m_nTotalHits;
+  const uint32_t nSideCells = m_Properties.nSideCells();
+  const double recoveryRate = 1 / m_Properties.recoveryTime();
+  const double* times = ctx.m_Hits.times().data();
+  float* amplitudes = ctx.m_Hits.amplitudes().data();
+  const uint32_t* rows = ctx.m_Hits.rows().data();
+  const uint32_t* cols = ctx.m_Hits.cols().data();
+
+  const uint32_t generation = nextGeneration(ctx);
+  ctx.m_CellHead.resize(ctx.m_CellStamp.size());
+  uint32_t* stamp = ctx.m_CellStamp.data();
+  uint32_t* head = ctx.m_CellHead.data();
+  ctx.m_NextHit.resize(nTotalHits);
+  uint32_t* next = ctx.m_NextHit.data();
+  std::vector<uint32_t>& occupied = ctx.m_OccupiedCells;
+  occupied.clear();
+
+  // Hits in the same cell are chained in a linked list starting from the
+  // head of the cell.
+  for (uint32_t i = 0; i < nTotalHits; ++i) {
+    const uint32_t cell = cols[i] + nSideCells * rows[i];
+    if (stamp[cell] != generation) {
+      stamp[cell] = generation;
+      head[cell] = kNoHit;
+      occupied.push_back(cell);
+    }
+    next[i] = head[cell];
+    head[cell] = i;
+  }
+
+  // Iterate over occupied cells
+  std::vector<uint32_t>& hits = ctx.m_CellHits;
+  for (const uint32_t cell : occupied) {
+    // If less than two hit in same cell go ahead
+    if (next[head[cell]] == kNoHit) { continue; }
+    hits.clear();
+    for (uint32_t i = head[cell]; i != kNoHit; i = next[i]) {
+      hits.push_back(i);
+    }
+    // Index is used to break ties so results do not depend on list order
+    std::sort(hits.begin(), hits.end(), [times](const uint32_t a, const uint32_t b) {
+      return times[a] < times[b] || (times[a] == times[b] && a < b);
+    });
+    // Calculate amplitude
+    const uint32_t n_hits = hits.size();
+    for (uint32_t i = 1; i < n_hits; ++i) {
+      const double delay = times[hits[i]] - times[hits[i - 1]];
+      amplitudes[hits[i]] *= 1 - exp(-delay * recoveryRate);
+    }
+  }
+}
+
+// Stable LSD radix sort of indices by 32 bits keys using 8 bits digits.
+// On return order contains indices sorted by key, keys are sorted too.
+static void radixSort(std::vector<uint32_t>& keys, std::vector<uint32_t>& order, std::vector<uint32_t>& tmpKeys,
+                      std::vector<uint32_t>& tmpOrder) {
+  const uint32_t n = keys.size();
+  // Small inputs are faster with insertion sort (stable too)
+  if (n < 64) {
+    for (uint32_t i = 1; i < n; ++i) {
+      const uint32_t key = keys[i];
+      const uint32_t idx = order[i];
+      uint32_t j = i;
+      for (; j > 0 && keys[j - 1] > key; --j) {
+        keys[j] = keys[j - 1];
+        order[j] = order[j - 1];
+      }
+      keys[j] = key;
+      order[j] = idx;
+    }
+    return;
+  }
+
+  tmpKeys.resize(n);
+  tmpOrder.resize(n);
+  for (uint32_t shift = 0; shift < 32; shift += 8) {
+    uint32_t count[256] = {0};
+    for (uint32_t i = 0; i < n; ++i) {
+      ++count[(keys[i] >> shift) & 0xFF];
+    }
+    // All keys have same digit, nothing to do in this pass
+    if (count[(keys[0] >> shift) & 0xFF] == n) { continue; }
+    uint32_t sum = 0;
+    for (uint32_t d = 0; d < 256; ++d) {
+      const uint32_t c = count[d];
+      count[d] = sum;
+      sum += c;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+      const uint32_t dst = count[(keys[i] >> shift) & 0xFF]++;
+      tmpKeys[dst] = keys[i];
+      tmpOrder[dst] = order[i];
+    }
+    keys.swap(tmpKeys);
+    order.swap(tmpOrder);
+  }
+}
+
+void SiPMModel::recoveryTimeSorted(SiPMEventContext& ctx) const {
+  const uint32_t nTotalHits = ctx.m_nTotalHits;
+  const uint32_t nSideCells = m_Properties.nSideCells();
+  const double recoveryRate = 1 / m_Properties.recoveryTime();
+  const double* times = ctx.m_Hits.times().data();
+  float* amplitudes = ctx.m_Hits.amplitudes().data();
+  const uint32_t* rows = ctx.m_Hits.rows().data();
+  const uint32_t* cols = ctx.m_Hits.cols().data();
+
+  // Times are quantized in 2^32 steps over the signal length (~0.1 fs for
+  // 500 ns) and hits with same key are kept in index order
+  const double scale = static_cast<double>(UINT32_MAX) / m_Properties.signalLength();
+  std::vector<uint32_t>& keys = ctx.m_SortKeys;
+  std::vector<uint32_t>& order = ctx.m_SortedHits;
+  keys.resize(nTotalHits);
+  order.resize(nTotalHits);
+  for (uint32_t i = 0; i < nTotalHits; ++i) {
+    keys[i] = static_cast<uint32_t>(std::min(times[i] * scale, static_cast<double>(UINT32_MAX)));
+    order[i] = i;
+  }
+  radixSort(keys, order, ctx.m_SortTmpKeys, ctx.m_SortTmpHits);
+
+  // Single sweep in time order remembering last hit time of each cell
+  const uint32_t generation = nextGeneration(ctx);
+  ctx.m_CellLastTime.resize(ctx.m_CellStamp.size());
+  uint32_t* stamp = ctx.m_CellStamp.data();
+  double* lastTime = ctx.m_CellLastTime.data();
+  for (uint32_t i = 0; i < nTotalHits; ++i) {
+    const uint32_t hit = order[i];
+    const uint32_t cell = cols[hit] + nSideCells * rows[hit];
+    const double time = times[hit];
+    if (stamp[cell] == generation) {
+      // Hits closer than the quantization step might be swapped
+      const double delay = std::max(time - lastTime[cell], 0.0);
+      amplitudes[hit] *= 1 - exp(-delay * recoveryRate);
+    } else {
+      stamp[cell] = generation;
+    }
+    lastTime[cell] = time;
+  }
+}
+
+void SiPMModel::generateSignal(SiPMEventContext& ctx, float* signal) const {
+  // Sub-sample timing of the template is kept only by the polyphase bank
+  if (m_Properties.hasPulseTemplate()) {
+    generateSignalPolyphase(ctx, signal);
+    return;
+  }
+  switch (m_Properties.signalEngine()) {
+    case SiPMProperties::SignalEngine::kAuto:
+      if (ctx.m_nTotalHits > m_FftMinHits) {
+        generateSignalFft(ctx, signal);
+      } else {
+        generateSignalDirect(ctx, signal);
+      }
+      return;
+    case SiPMProperties::SignalEngine::kFft:
+      generateSignalFft(ctx, signal);
+      return;
+    case SiPMProperties::SignalEngine::kDirect:
+      generateSignalDirect(ctx, signal);
+      return;
+    case SiPMProperties::SignalEngine::kRecursive:
+      generateSignalRecursive(ctx, signal);
+      return;
+  }
+}
+
+void SiPMModel::generateSignalDirect(const SiPMEventContext& ctx, float* signal) const {
+  const uint32_t nTotalHits = ctx.m_nTotalHits;
+  const uint32_t nSignalPoints = m_Properties.nSignalPoints();
+  const double recSampling = 1.0 / m_Properties.sampling();
+  const double* times = ctx.m_Hits.times().data();
+  const float* amplitudes = ctx.m_Hits.amplitudes().data();
+  // If hits are sorted by time the signal is accumulated moving forward
+  const bool timeSorted = m_Properties.recoveryMode() == SiPMProperties::RecoveryMode::kTimeSorted;
+  const uint32_t* order = timeSorted ? ctx.m_SortedHits.data() : nullptr;
+
+  for (uint32_t h = 0; h < nTotalHits; ++h) {
+    const uint32_t i = order ? order[h] : h;
+    const uint32_t time = static_cast<uint32_t>(times[i] * recSampling);
+    if (time >= nSignalPoints) { continue; }
+    const float amplitude = amplitudes[i];
+    const uint32_t endPoint = nSignalPoints - time;
+
+    // Vectorized with the instruction set selected at runtime
+    SiPMDispatch::accumulate(signal + time, m_SignalShape.data(), amplitude, endPoint);
+  }
+}
+
+void SiPMModel::generateSignalRecursive(SiPMEventContext& ctx, float* signal) const {
+  const uint32_t nTotalHits = ctx.m_nTotalHits;
+  const uint32_t nSignalPoints = m_Properties.nSignalPoints();
+  const uint32_t nComponents = m_PulseWeights.size();
+  const double recSampling = 1.0 / m_Properties.sampling();
+  const double* times = ctx.m_Hits.times().data();
+  const float* amplitudes = ctx.m_Hits.amplitudes().data();
+
+  // One impulse train for each exponential component
+  std::vector<double>& impulses = ctx.m_Impulses;
+  impulses.assign(static_cast<size_t>(nComponents) * nSignalPoints, 0);
+
+  for (uint32_t i = 0; i < nTotalHits; ++i) {
+    // Impulse is placed in first sample after the hit and weighted by the
+    // value of each exponential at that sample
+    const double time = times[i] * recSampling;
+    const double first = std::ceil(time);
+    if (first >= nSignalPoints) { continue; }
+    const uint32_t idx = static_cast<uint32_t>(first);
+    const double delta = first - time;
+    for (uint32_t c = 0; c < nComponents; ++c) {
+      impulses[c * nSignalPoints + idx] += amplitudes[i] * m_PulseWeights[c] * std::exp(-delta * m_PulseRates[c]);
+    }
+  }
+
+  // First order recursive filter y[n] = y[n-1] * exp(-1/tau) + x[n]
+  for (uint32_t c = 0; c < nComponents; ++c) {
+    const double decay = std::exp(-m_PulseRates[c]);
+    const double* x = impulses.data() + c * nSignalPoints;
+    double y = 0;
+    for (uint32_t n = 0; n < nSignalPoints; ++n) {
+      y = y * decay + x[n];
+      signal[n] += y;
+    }
+  }
+}
+
+void SiPMModel::generateSignalPolyphase(const SiPMEventContext& ctx, float* signal) const {
+  const uint32_t nTotalHits = ctx.m_nTotalHits;
+  const uint32_t nSignalPoints = m_Properties.nSignalPoints();
+  const uint32_t nPhases = m_Properties.pulsePhases();
+  const double recSampling = 1.0 / m_Properties.sampling();
+  const double* times = ctx.m_Hits.times().data();
+  const float* amplitudes = ctx.m_Hits.amplitudes().data();
+
+  for (uint32_t i = 0; i < nTotalHits; ++i) {
+    const double t = times[i] * recSampling;
+    // Sampling point before the hit and phase closest to its delay
+    uint32_t time = static_cast<uint32_t>(t);
+    uint32_t phase = static_cast<uint32_t>((t - time) * nPhases + 0.5);
+    if (phase == nPhases) {
+      phase = 0;
+      ++time;
+    }
+    if (time >= nSignalPoints) { continue; }
+    const float amplitude = amplitudes[i];
+    const uint32_t endPoint = nSignalPoints - time;
+
+    const float* phasePtr = m_PulsePhases.data() + static_cast<size_t>(phase) * nSignalPoints;
+
+    SiPMDispatch::accumulate(signal + time, phasePtr, amplitude, endPoint);
+  }
+}
+
+void SiPMModel::generateSignalFft(SiPMEventContext& ctx, float* signal) const {
+  const uint32_t nTotalHits = ctx.m_nTotalHits;
+  const uint32_t nSignalPoints = m_Properties.nSignalPoints();
+  const uint32_t nBins = m_Fft.nBins();
+  const double recSampling = 1.0 / m_Properties.sampling();
+  const double* times = ctx.m_Hits.times().data();
+  const float* amplitudes = ctx.m_Hits.amplitudes().data();
+
+  // Histogram of amplitudes, times are truncated as in direct engine
+  std::vector<double>& buffer = ctx.m_FftBuffer;
+  buffer.assign(m_Fft.size(), 0);
+  for (uint32_t i = 0; i < nTotalHits; ++i) {
+    const uint32_t time = static_cast<uint32_t>(times[i] * recSampling);
+    if (time >= nSignalPoints) { continue; }
+    buffer[time] += amplitudes[i];
+  }
+
+  std::vector<std::complex<double>>& spectrum = ctx.m_FftSpectrum;
+  spectrum.resize(nBins);
+  m_Fft.forward(buffer.data(), spectrum.data());
+  for (uint32_t k = 0; k < nBins; ++k) {
+    spectrum[k] *= m_ShapeSpectrum[k];
+  }
+  m_Fft.inverse(spectrum.data(), buffer.data());
+
+  for (uint32_t i = 0; i < nSignalPoints; ++i) {
+    signal[i] += buffer[i];
+  }
+}
+
+std::ostream& operator<<(std::ostream& out, const SiPMModel& obj) {
+  out << std::setprecision(2) << std::fixed;
+  out << "===> SiPM Model <===\n";
+  out << "Address: " << std::hex << std::addressof(obj) << "\n";
+  out << obj.m_Properties;
+  return out;
+}
+} // namespace sipm
@@ -55,13 +55,17 @@ void SiPMProperties::setProperty(const std::string& prop, const double val) {
     setDXt(val);
   } else if (aProp == "ap") {
     setAp(val);
+  } else if (aProp == "noisebanksize") {
+    setNoiseBankSize(val);
+  } else if (aProp == "pulsephases") {
+    setPulsePhases(val);
   } else {
     std::cerr << "Property: " << prop << " not found!" << std::endl;
   }
 }
 
-void SiPMProperties::setPdeSpectrum(const std::vector<double>& wav, const std::vector<double>& pde) {
-  static constexpr uint32_t N = 32;
+void SiPMProperties::setPdeSpectrum(const std::vector<double>& wav, const std::vector<double>& pde,
+                                    const uint32_t N) {
   std::map<double, double> inputSpectrum;
 
   for (uint32_t i = 0; i < wav.size(); ++i) {
@@ -71,6 +75,7 @@ void SiPMProperties::setPdeSpectrum(const std::vector<double>& wav, const std::v
   const double xmin = inputSpectrum.cbegin()->first;
   const double xmax = inputSpectrum.crbegin()->first;
   const double dx = (xmax - xmin) / N;
+  m_PdeSpectrum.clear();
   for (uint32_t i = 0; i < N; ++i) {
     const double newx = xmin + i * dx;
     auto it1 = inputSpectrum.upper_bound(newx);
@@ -104,6 +109,22 @@ void SiPMProperties::setPdeSpectrum(const std::vector<double>& wav, const std::v
   m_HasPde = PdeType::kSpectrumPde;
 }
 
+void SiPMProperties::setHitMap(const std::vector<double>& map, const uint32_t nRows, const uint32_t nCols) {
+  if (nRows == 0 || nCols == 0 || map.size() != static_cast<size_t>(nRows) * nCols) {
+    std::cerr << "Hit map of " << map.size() << " bins does not match " << nRows << "x" << nCols
+              << ", using uniform hit distribution" << std::endl;
+    m_HitMap.clear();
+    m_HitMapRows = 0;
+    m_HitMapCols = 0;
+    m_HitDistribution = HitDistribution::kUniform;
+    return;
+  }
+  m_HitMap = map;
+  m_HitMapRows = nRows;
+  m_HitMapCols = nCols;
+  m_HitDistribution = HitDistribution::kCustomMap;
+}
+
 SiPMProperties SiPMProperties::readSettings(const std::string& fname) {
   SiPMProperties retval;
   std::ifstream file(fname);
@@ -150,8 +171,16 @@ std::ostream& operator<<(std::ostream& out, const SiPMProperties& obj) {
     case (SiPMProperties::HitDistribution::kGaussian):
       out << "Gaussian\n";
       break;
+    case (SiPMProperties::HitDistribution::kCustomMap):
+      out << "Custom map of " << obj.m_HitMapRows << "x" << obj.m_HitMapCols << " bins\n";
+      break;
   }
   out << "Cell recovery time: " << obj.m_RecoveryTime << " ns\n";
+  if (obj.m_RecoveryMode == SiPMProperties::RecoveryMode::kTimeSorted) {
+    out << "Cell recovery mode: Time sorted\n";
+  } else {
+    out << "Cell recovery mode: Per cell\n";
+  }
   if (obj.m_HasDcr) {
     out << "Dark count rate: " << obj.m_Dcr / 1e3 << " kHz\n";
   } else {
@@ -176,8 +205,19 @@ std::ostream& operator<<(std::ostream& out, const SiPMProperties& obj) {
   }
   out << "Cell-to-cell gain variation: " << obj.m_Ccgv * 100 << " %\n";
   out << "SNR: " << obj.m_SnrdB << " dB\n";
+  if (obj.m_NoiseMode == SiPMProperties::NoiseMode::kBank) {
+    out << "Noise mode: Bank of " << obj.m_NoiseBankSize << " samples";
+    out << (obj.m_NoiseSpectrum.empty() ? " (white)\n" : " (colored)\n");
+  } else {
+    out << "Noise mode: Generated\n";
+  }
   if (obj.m_HasPde == SiPMProperties::PdeType::kSimplePde) {
     out << "Photon detection efficiency: " << obj.m_Pde * 100 << " %\n";
+    if (obj.m_PdeSampling == SiPMProperties::PdeSampling::kBinomial) {
+      out << "Photon detection sampling: Binomial\n";
+    } else {
+      out << "Photon detection sampling: Per photon\n";
+    }
   } else if (obj.m_HasPde == SiPMProperties::PdeType::kSpectrumPde) {
     out << "Photon detection efficiency: depending on wavelength\n";
     out << "Photon wavelength\tDetection efficiency\n";
@@ -187,13 +227,34 @@ std::ostream& operator<<(std::ostream& out, const SiPMProperties& obj) {
   } else {
     out << "Photon detection efficiency is OFF (100 %)\n";
   }
-  out << "Rising time of signal: " << obj.m_RiseTime << " ns\n";
-  out << "Falling time of signal (fast): " << obj.m_FallTimeFast << " ns\n";
-  if (obj.m_HasSlowComponent) {
-    out << "Falling time of signal (slow): " << obj.m_FallTimeSlow << " ns\n";
-    out << "Slow component fraction: " << obj.m_SlowComponentFraction * 100 << " %\n";
+  if (obj.hasPulseTemplate()) {
+    out << "Signal shape: pulse template of " << obj.m_PulseTemplate.size() << " points sampled at "
+        << obj.m_PulseTemplateSampling << " ns\n";
+    out << "Pulse template phases: " << obj.pulsePhases() << "\n";
+  } else {
+    out << "Rising time of signal: " << obj.m_RiseTime << " ns\n";
+    out << "Falling time of signal (fast): " << obj.m_FallTimeFast << " ns\n";
+    if (obj.m_HasSlowComponent) {
+      out << "Falling time of signal (slow): " << obj.m_FallTimeSlow << " ns\n";
+      out << "Slow component fraction: " << obj.m_SlowComponentFraction * 100 << " %\n";
+    }
   }
   out << "Signal length: " << obj.m_SignalLength << " ns\n";
+  out << "Signal engine: ";
+  switch (obj.m_SignalEngine) {
+    case (SiPMProperties::SignalEngine::kAuto):
+      out << "Auto\n";
+      break;
+    case (SiPMProperties::SignalEngine::kDirect):
+      out << "Direct\n";
+      break;
+    case (SiPMProperties::SignalEngine::kRecursive):
+      out << "Recursive\n";
+      break;
+    case (SiPMProperties::SignalEngine::kFft):
+      out << "FFT\n";
+      break;
+  }
   out << "Sampling time: " << obj.m_Sampling << " ns\n";
   return out;
 }
@@ -1,6 +1,9 @@
 #include "SiPMRandom.h"
 
+#include "SiPMMath.h"
 #include "SiPMTypes.h"
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -17,22 +20,58 @@ static uint64_t rngInit() {
 
 namespace sipm {
 namespace SiPMRng {
-void Xorshift256plus::seed() {
-  s[0] = lcg64(rngInit());
-  for (uint8_t i = 1; i < 4; ++i) {
-    s[i] = lcg64(s[i - 1]);
+// Jump polynomials from the reference implementation of xoshiro256+
+static constexpr uint64_t JUMP[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+static constexpr uint64_t LONG_JUMP[] = {0x76e15d3efefdcbbf, 0xc5004e441c522fb3, 0x77710069854ee241,
+                                         0x39109bb02acbe635};
+
+// Applies a jump polynomial to a single xoshiro256 state
+static void jumpState(uint64_t* st, const uint64_t* poly) noexcept {
+  uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for (int i = 0; i < 4; ++i) {
+    for (int b = 0; b < 64; ++b) {
+      if (poly[i] & (UINT64_C(1) << b)) {
+        s0 ^= st[0];
+        s1 ^= st[1];
+        s2 ^= st[2];
+        s3 ^= st[3];
+      }
+      const uint64_t t = st[1] << 17;
+      st[2] ^= st[0];
+      st[3] ^= st[1];
+      st[1] ^= st[2];
+      st[0] ^= st[3];
+      st[2] ^= t;
+      st[3] = (st[3] << 45) | (st[3] >> (64 - 45));
+    }
   }
-#ifdef __AVX512F__
-  __s[0][0] = lcg64(rngInit());
-  for (int i = 1; i < 8; ++i) {
-    __s[0][i] = lcg64(__s[0][i - 1]);
+  st[0] = s0;
+  st[1] = s1;
+  st[2] = s2;
+  st[3] = s3;
+}
+
+void Xorshift256plus::seed() { seed(rngInit()); }
+
+void Xorshift256plus::seed(const uint64_t aseed) {
+  // First generator starts five steps of the lcg after the seed
+  uint64_t st[4] = {aseed};
+  for (uint8_t i = 0; i < 5; ++i) {
+    st[0] = lcg64(st[0]);
   }
   for (uint8_t i = 1; i < 4; ++i) {
-    for (int j = 0; j < 8; ++j) {
-      __s[i][j] = lcg64(__s[i - 1][j]);
+    st[i] = lcg64(st[i - 1]);
+  }
+  // Other generators start 2^192 steps apart, so that their streams never
+  // overlap, neither do the substreams obtained with jump
+  for (uint32_t j = 0; j < L; ++j) {
+    if (j > 0) {
+      jumpState(st, LONG_JUMP);
+    }
+    for (uint8_t i = 0; i < 4; ++i) {
+      s[i][j] = st[i];
     }
   }
-#endif
   index = N;
   // Call rng few times
   for (uint32_t i = 0; i < 1 << 16; ++i) {
@@ -40,35 +79,169 @@ void Xorshift256plus::seed() {
   }
 }
 
-void Xorshift256plus::seed(const uint64_t aseed) {
-  s[0] = lcg64(aseed);
-  for (uint8_t i = 1; i < 4; ++i) {
-    s[i] = lcg64(s[i - 1]);
+void Xorshift256plus::getRand(uint64_t* __restrict array, const uint32_t n) noexcept {
+  const uint32_t steps = n / L;
+  SiPMDispatch::xoshiro256plus(s, array, steps);
+  // Handle leftover if n is not a multiple of 8
+  if (steps * L < n) {
+    uint64_t last[L];
+    SiPMDispatch::xoshiro256plus(s, last, 1);
+    std::memcpy(array + steps * L, last, (n - steps * L) * sizeof(uint64_t));
   }
-#ifdef __AVX512F__
-  __s[0][0] = lcg64(s[3]);
-  for (int i = 1; i < 8; ++i) {
-    __s[0][i] = lcg64(__s[0][i - 1]);
+}
+
+void Xorshift256plus::getRand(uint32_t* __restrict array, const uint32_t n) noexcept {
+  // Each step gives 8 uint64_t values, split into 16 uint32_t values
+  const uint32_t steps = n / (2 * L);
+  SiPMDispatch::xoshiro256plus(s, array, steps);
+  if (steps * 2 * L < n) {
+    uint32_t last[2 * L];
+    SiPMDispatch::xoshiro256plus(s, last, 1);
+    std::memcpy(array + steps * 2 * L, last, (n - steps * 2 * L) * sizeof(uint32_t));
   }
-  for (uint8_t i = 1; i < 4; ++i) {
-    for (int j = 0; j < 8; ++j) {
-      __s[i][j] = lcg64(__s[i - 1][j]);
+}
+
+void Xorshift256plus::applyJump(const uint64_t* poly) noexcept {
+  // Each lane is an independent generator
+  for (uint32_t j = 0; j < L; ++j) {
+    uint64_t st[4] = {s[0][j], s[1][j], s[2][j], s[3][j]};
+    jumpState(st, poly);
+    for (int i = 0; i < 4; ++i) {
+      s[i][j] = st[i];
     }
   }
-#endif
+  // Values in buffer belong to the old position of the stream
   index = N;
-  // Call rng few
-  for (uint32_t i = 0; i < 1 << 16; ++i) {
-    this->operator()();
+}
+
+void Xorshift256plus::jump() noexcept { applyJump(JUMP); }
+
+void Xorshift256plus::long_jump() noexcept {
+  // Generators start 2^192 steps apart, jumping past all of them keeps
+  // generators obtained with long jumps disjoint
+  for (uint32_t j = 0; j < L; ++j) {
+    applyJump(LONG_JUMP);
+  }
+}
+
+Xorshift256plus Xorshift256plus::split(const uint64_t k) const {
+  Xorshift256plus substream(*this);
+  substream.index = N;
+  for (uint64_t i = 0; i < k; ++i) {
+    substream.jump();
   }
+  return substream;
 }
+
+void Philox4x32::seed() { seed(rngInit()); }
 } // namespace SiPMRng
 
+namespace {
+// Compile time versions of exp, log and sqrt, used only to build the ziggurat
+// tables. Accurate to few ulp in the range of the tables
+constexpr double kLn2 = 0.693147180559945309417232121458;
+
+constexpr double constExp(const double x) {
+  // x = k * ln2 + r with |r| <= ln2 / 2
+  const int64_t k = static_cast<int64_t>(x / kLn2 + (x < 0 ? -0.5 : 0.5));
+  const double r = x - k * kLn2;
+  double term = 1;
+  double sum = 1;
+  for (int i = 1; i < 30; ++i) {
+    term *= r / i;
+    sum += term;
+  }
+  for (int64_t i = 0; i < k; ++i) {
+    sum *= 2;
+  }
+  for (int64_t i = 0; i > k; --i) {
+    sum /= 2;
+  }
+  return sum;
+}
+
+constexpr double constLog(double x) {
+  // x = m * 2^e with m in [1, 2) and log(m) = 2 * atanh((m - 1) / (m + 1))
+  int64_t e = 0;
+  for (; x >= 2; ++e) {
+    x /= 2;
+  }
+  for (; x < 1; --e) {
+    x *= 2;
+  }
+  const double z = (x - 1) / (x + 1);
+  double term = z;
+  double sum = 0;
+  for (int i = 1; i < 80; i += 2) {
+    sum += term / i;
+    term *= z * z;
+  }
+  return 2 * sum + e * kLn2;
+}
+
+constexpr double constSqrt(const double x) {
+  if (x <= 0) {
+    return 0;
+  }
+  double y = x > 1 ? x : 1;
+  for (int i = 0; i < 200; ++i) {
+    const double next = 0.5 * (y + x / y);
+    if (next == y) {
+      break;
+    }
+    y = next;
+  }
+  return y;
+}
+
+/**
+ * Layers of a ziggurat with N layers of equal area v covering a decreasing
+ * density f(x), x >= 0, normalized to f(0) = 1. Layer i goes from x[i + 1] to
+ * x[i] horizontally and from f[i] to f[i + 1] vertically, layer 0 is the base
+ * made of a rectangle up to r and the tail, so x[0] = v / f(r) is the width
+ * of a rectangle with the same area. Points below x[i + 1] are always inside
+ * the density.
+ */
+template <uint32_t N>
+struct ZigguratTable {
+  double r;
+  double x[N + 1];
+  double f[N + 1];
+};
+
+constexpr double gaussianDensity(const double x) { return constExp(-0.5 * x * x); }
+constexpr double gaussianInverse(const double y) { return y < 1 ? constSqrt(-2 * constLog(y)) : 0; }
+constexpr double exponentialDensity(const double x) { return constExp(-x); }
+constexpr double exponentialInverse(const double y) { return y < 1 ? -constLog(y) : 0; }
+
+template <uint32_t N, typename Density, typename Inverse>
+constexpr ZigguratTable<N> makeZigguratTable(const double r, const double v, Density f, Inverse inverse) {
+  ZigguratTable<N> table{};
+  table.r = r;
+  table.x[0] = v / f(r);
+  table.x[1] = r;
+  for (uint32_t i = 1; i < N - 1; ++i) {
+    table.x[i + 1] = inverse(v / table.x[i] + f(table.x[i]));
+  }
+  table.x[N] = 0;
+  for (uint32_t i = 0; i <= N; ++i) {
+    table.f[i] = f(table.x[i]);
+  }
+  return table;
+}
+
+// Parameters from Marsaglia and Tsang
+constexpr ZigguratTable<128> kGaussianTable =
+  makeZigguratTable<128>(3.442619855899, 9.91256303526217e-3, gaussianDensity, gaussianInverse);
+constexpr ZigguratTable<256> kExponentialTable =
+  makeZigguratTable<256>(7.69711747013104972, 3.949659822581572e-3, exponentialDensity, exponentialInverse);
+} // namespace
+
 // SCALAR //
 
 // Generate two 32 bit floating from one 64 bit integer
 pair<float, float> SiPMRandom::RandF2() noexcept {
-  const uint64_t u64 = m_rng();
+  const uint64_t u64 = next();
   const uint32_t lo = static_cast<uint32_t>(u64);
   const uint32_t hi = static_cast<uint32_t>(u64 >> 32);
   const float first = (lo >> 8) * 0x1p-24f;
@@ -77,6 +250,14 @@ pair<float, float> SiPMRandom::RandF2() noexcept {
 }
 
 /**
+ * Uses the multiplication method when mu < 10 and the PTRS transformed
+ * rejection algorithm otherwise, so the expected number of uniforms does not
+ * grow with mu.
+ *
+ * REFERENCE: W. Hoermann (1993): The transformed rejection method for
+ *            generating Poisson random variables,
+ *            Insurance: Mathematics and Economics 12 (1993), 39-45.
+ *
  * @param mu Mean value of the poisson distribution
  */
 uint32_t SiPMRandom::randPoisson(const double mu) noexcept {
@@ -84,231 +265,364 @@ uint32_t SiPMRandom::randPoisson(const double mu) noexcept {
     return 0;
   }
 
-  const double emu = exp(-mu);
-  double prod = 1.0;
-  uint32_t out = 0;
+  if (mu < 10) {
+    const double emu = exp(-mu);
+    double prod = 1.0;
+    uint32_t out = 0;
 
-  while (1) {
-    const double U = Rand();
-    prod *= U;
-    if (prod > emu) {
-      out++;
-    } else {
-      return out;
+    while (1) {
+      const double U = Rand();
+      prod *= U;
+      if (prod > emu) {
+        out++;
+      } else {
+        return out;
+      }
     }
   }
-}
 
-/**
- * @param mu Mean value of the exponential distribution
- * @return double value from exponential distribution
- */
-double SiPMRandom::randExponential(const double mu) noexcept { return -log(Rand()) * mu; }
+  const double slam = sqrt(mu);
+  const double loglam = log(mu);
+  const double b = 0.931 + 2.53 * slam;
+  const double a = -0.059 + 0.02483 * b;
+  const double invalpha = 1.1239 + 1.1328 / (b - 3.4);
+  const double vr = 0.9277 - 3.6224 / (b - 2);
+  while (true) {
+    const double U = Rand() - 0.5;
+    const double V = Rand();
+    const double us = 0.5 - fabs(U);
+    if (us <= 0) {
+      continue;
+    }
+    const int64_t k = static_cast<int64_t>(floor((2 * a / us + b) * U + mu + 0.43));
+    if ((us >= 0.07) && (V <= vr)) {
+      return k;
+    }
+    if ((k < 0) || ((us < 0.013) && (V > us))) {
+      continue;
+    }
+    if (log(V) + log(invalpha) - log(a / (us * us) + b) <= -mu + k * loglam - std::lgamma(k + 1.0)) {
+      return k;
+    }
+  }
+}
 
 /**
- * @param mu Mean value of the exponential distribution
- * @return float value from exponential distribution
+ * Uses inversion when n * min(p, 1 - p) < 30 and the BTPE algorithm
+ * otherwise, so the expected number of uniforms does not grow with n.
+ *
+ * REFERENCE: V. Kachitvichyanukul and B. W. Schmeiser (1988):
+ *            Binomial random variate generation,
+ *            Communications of the ACM 31 (1988), 216-222.
+ *
+ * @param n Number of trials
+ * @param p Probability of success of each trial
  */
-float SiPMRandom::randExponentialF(const float mu) noexcept { return -logf(Rand<float>()) * mu; }
-/**
-*   @brief Samples a random number from the standard Normal (Gaussian) Distribution with the given mean and sigma.
-*
-* Uses the Acceptance-complement ratio from W. Hoermann and G. Derflinger
-* This is one of the fastest existing method for generating normal random variables.
-* It is a factor 2/3 faster than the polar (Box-Muller) method used in the previous
-* version of TRandom::Gaus. The speed is comparable to the Ziggurat method (from Marsaglia)
-* implemented for example in GSL.
-*
-* REFERENCE:  - W. Hoermann and G. Derflinger (1990):
-*              The ACR Method for generating normal random variables,
-*              OR Spektrum 12 (1990), 181-185.
-*
-* Implementation taken from
-* UNURAN (c) 2000  W. Hoermann & J. Leydold, Institut f. Statistik, WU Wien
-
-* @param mu Mean value of the gaussian distribution
-* @param sigma Standard deviation of the gaussian distribution
-* @return double value from gaussian distribution
-*/
-double SiPMRandom::randGaussian(const double mu, const double sigma) noexcept {
-  static constexpr double kC1 = 1.448242853;
-  static constexpr double kC2 = 3.307147487;
-  static constexpr double kC3 = 1.46754004;
-  static constexpr double kD1 = 1.036467755;
-  static constexpr double kD2 = 5.295844968;
-  static constexpr double kD3 = 3.631288474;
-  static constexpr double kHm = 0.483941449;
-  static constexpr double kZm = 0.107981933;
-  static constexpr double kHp = 4.132731354;
-  static constexpr double kZp = 18.52161694;
-  static constexpr double kPhln = 0.4515827053;
-  static constexpr double kHm1 = 0.516058551;
-  static constexpr double kHp1 = 3.132731354;
-  static constexpr double kHzm = 0.375959516;
-  static constexpr double kHzmp = 0.591923442;
-  /*zhm 0.967882898*/
-
-  static constexpr double kAs = 0.8853395638;
-  static constexpr double kBs = 0.2452635696;
-  static constexpr double kCs = 0.2770276848;
-  static constexpr double kB = 0.5029324303;
-  static constexpr double kX0 = 0.4571828819;
-  static constexpr double kYm = 0.187308492;
-  static constexpr double kS = 0.7270572718;
-  static constexpr double kT = 0.03895759111;
-
-  do {
-    const double y = Rand();
-
-    if (y > kHm1) {
-      const double result = kHp * y - kHp1;
-      return result * sigma + mu;
+uint32_t SiPMRandom::randBinomial(const uint32_t n, const double p) noexcept {
+  if (n == 0 || p <= 0) {
+    return 0;
+  }
+  if (p >= 1) {
+    return n;
+  }
+  // Sample the smaller of the two probabilities and flip at the end
+  const double r = std::min(p, 1 - p);
+  const double q = 1 - r;
+  const double nr = n * r;
+  uint32_t y;
+
+  if (nr < 30) {
+    // Inversion: walk the pmf from 0, restarting if the bound is passed
+    const double qn = exp(n * log(q));
+    const double bound = std::min<double>(n, nr + 10 * sqrt(nr * q + 1));
+    const double s = r / q;
+    y = 0;
+    double px = qn;
+    double u = Rand();
+    while (u > px) {
+      ++y;
+      if (y > bound) {
+        y = 0;
+        px = qn;
+        u = Rand();
+      } else {
+        u -= px;
+        px *= (n - y + 1) * s / y;
+      }
     }
+    return p > 0.5 ? n - y : y;
+  }
 
-    if (y < kZm) {
-      const double rn = kZp * y - 1;
-      const double result = (rn > 0) ? (1 + rn) : (-1 + rn);
-      return result * sigma + mu;
+  // BTPE setup: triangle, parallelograms and exponential tails
+  const double nrq = nr * q;
+  const double fm = nr + r;
+  const int64_t m = static_cast<int64_t>(fm);
+  const double p1 = floor(2.195 * sqrt(nrq) - 4.6 * q) + 0.5;
+  const double xm = m + 0.5;
+  const double xl = xm - p1;
+  const double xr = xm + p1;
+  const double c = 0.134 + 20.5 / (15.3 + m);
+  double a = (fm - xl) / (fm - xl * r);
+  const double laml = a * (1 + a / 2);
+  a = (xr - fm) / (xr * q);
+  const double lamr = a * (1 + a / 2);
+  const double p2 = p1 * (1 + 2 * c);
+  const double p3 = p2 + c / laml;
+  const double p4 = p3 + c / lamr;
+
+  while (true) {
+    const double u = Rand() * p4;
+    double v = Rand();
+    int64_t iy;
+    if (u <= p1) {
+      // Triangular region: always accepted
+      y = static_cast<uint32_t>(floor(xm - p1 * v + u));
+      return p > 0.5 ? n - y : y;
     }
-
-    if (y < kHm) {
-      const double rn = 2 * Rand() - 1;
-      const double z = (rn > 0) ? 2 - rn : -2 - rn;
-      if ((kC1 - y) * (kC3 + abs(z)) < kC2) {
-        return z * sigma + mu;
+    if (u <= p2) {
+      // Parallelograms
+      const double x = xl + (u - p1) / c;
+      v = v * c + 1 - fabs(m - x + 0.5) / p1;
+      if (v > 1) {
+        continue;
+      }
+      iy = static_cast<int64_t>(floor(x));
+    } else if (u <= p3) {
+      // Left exponential tail
+      if (v == 0) {
+        continue;
       }
-      const double x = rn * rn;
-      if ((y + kD1) * (kD3 + x) < kD2) {
-        return rn * sigma + mu;
+      iy = static_cast<int64_t>(floor(xl + log(v) / laml));
+      if (iy < 0) {
+        continue;
       }
-      if (kHzmp - y < exp(-(z * z + kPhln) * 0.5)) {
-        return z * sigma + mu;
+      v *= (u - p2) * laml;
+    } else {
+      // Right exponential tail
+      if (v == 0) {
+        continue;
       }
-      if (y + kHzm < exp(-(x + kPhln) * 0.5)) {
-        return rn * sigma + mu;
+      iy = static_cast<int64_t>(floor(xr - log(v) / lamr));
+      if (iy > n) {
+        continue;
       }
+      v *= (u - p3) * lamr;
     }
 
-    while (true) {
-      double x = Rand();
-      double y = kYm * Rand();
-      const double z = kX0 - kS * x - y;
-      double rn;
-      if (z > 0) {
-        rn = 2 + y / x;
-      } else {
-        x = 1 - x;
-        y = kYm - y;
-        rn = -(2 + y / x);
+    const int64_t k = std::abs(iy - m);
+    if (k <= 20 || k >= nrq / 2 - 1) {
+      // Explicit evaluation of f(y) / f(m)
+      const double s = r / q;
+      const double as = s * (n + 1);
+      double f = 1;
+      for (int64_t i = m + 1; i <= iy; ++i) {
+        f *= as / i - s;
       }
-      if ((y - kAs + x) * (kCs + x) + kBs < 0) {
-        return rn * sigma + mu;
+      for (int64_t i = iy + 1; i <= m; ++i) {
+        f /= as / i - s;
       }
-      if (y < x + kT) {
-        if (rn * rn < 4 * (kB - log(x))) {
-          return rn * sigma + mu;
-        }
+      if (v <= f) {
+        y = iy;
+        return p > 0.5 ? n - y : y;
       }
+      continue;
+    }
+
+    // Squeeze using bounds on log(f(y) / f(m))
+    const double rho = (k / nrq) * ((k * (k / 3.0 + 0.625) + 1.0 / 6) / nrq + 0.5);
+    const double t = -static_cast<double>(k * k) / (2 * nrq);
+    const double A = log(v);
+    if (A < t - rho) {
+      y = iy;
+      return p > 0.5 ? n - y : y;
     }
-  } while (false);
+    if (A > t + rho) {
+      continue;
+    }
+
+    // Final test with Stirling approximation of the factorials
+    const double x1 = iy + 1;
+    const double f1 = m + 1;
+    const double z = n + 1 - m;
+    const double w = n - iy + 1;
+    const auto stirling = [](const double x) {
+      const double x2 = x * x;
+      return (13860. - (462. - (132. - (99. - 140. / x2) / x2) / x2) / x2) / x / 166320.;
+    };
+    if (A <= xm * log(f1 / x1) + (n - m + 0.5) * log(z / w) + (iy - m) * log(w * r / (x1 * q)) + stirling(f1) +
+                  stirling(z) + stirling(x1) + stirling(w)) {
+      y = iy;
+      return p > 0.5 ? n - y : y;
+    }
+  }
+}
+
+/**
+ * Uses Floyd's algorithm: exactly min(k, n - k) uniform integers are drawn.
+ * When k > n / 2 the n - k excluded elements are sampled instead.
+ *
+ * @param n Number of elements
+ * @param k Number of elements to select
+ * @param mask Bitmask of (n + 63) / 64 words. Bit i is set if element i is
+ * selected
+ */
+void SiPMRandom::randSubset(const uint32_t n, const uint32_t k, uint64_t* mask) noexcept {
+  const uint32_t nWords = (n + 63) / 64;
+  const bool complement = k > n / 2;
+  const uint32_t nDraws = complement ? n - k : k;
+  // With complement the mask starts full and drawn elements are removed
+  std::fill(mask, mask + nWords, complement ? ~0ULL : 0ULL);
+  if (complement && (n & 63)) {
+    mask[nWords - 1] = (1ULL << (n & 63)) - 1;
+  }
+  for (uint32_t j = n - nDraws; j < n; ++j) {
+    uint32_t t = randInteger(j + 1);
+    // If t was already drawn take j instead, which cannot have been drawn yet
+    const bool drawn = ((mask[t >> 6] >> (t & 63)) & 1) != complement;
+    t = drawn ? j : t;
+    mask[t >> 6] ^= 1ULL << (t & 63);
+  }
+}
+
+/**
+ * Ziggurat method with 256 layers, see @ref randGaussian.
+ * @param mu Mean value of the exponential distribution
+ * @return double value from exponential distribution
+ */
+double SiPMRandom::randExponential(const double mu) noexcept { return standardExponential() * mu; }
+
+/**
+ * @param mu Mean value of the exponential distribution
+ * @return float value from exponential distribution
+ */
+float SiPMRandom::randExponentialF(const float mu) noexcept {
+  return static_cast<float>(standardExponential()) * mu;
+}
+
+// Converts 64 random bits stored in x to a double in [1,2) using the 52 most
+// significant bits as mantissa. Avoids the conversion from integer, that has
+// no vector instruction before AVX512
+static inline double unitInterval(const double* x) noexcept {
+  uint64_t b;
+  std::memcpy(&b, x, sizeof(b));
+  b = (b >> 12) | 0x3ff0000000000000;
+  double u;
+  std::memcpy(&u, &b, sizeof(u));
+  return u;
+}
+
+// Probability of an exponential with mean mu to be below max. Exponential is
+// skipped when the result is 1 in double precision
+static inline double exponentialCdf(const double mu, const double max) noexcept {
+  const double x = std::max(max, 0.0) / mu;
+  return x < 40 ? 1 - std::exp(-x) : 1;
 }
 
 /**
- * Float implemented of @ref randGaussian.
- * It is not faster than double version but is kept to avoid
- * casting double to float.
+ * Inverse of the CDF of the exponential restricted to [0, max]:
+ * x = -mu * log(1 - u * (1 - exp(-max / mu))). Costs one uniform and one log
+ * per value, plus an exponential if max is less than 40 times mu, and never
+ * rejects, so the cost is bounded also for max much smaller than mu. A
+ * negative max is treated as 0.
+ * @param mu Mean value of the exponential distribution before truncation
+ * @param max Upper limit of the generated values
+ * @return double value from truncated exponential distribution
+ */
+double SiPMRandom::randExponentialTrunc(const double mu, const double max) noexcept {
+  return -mu * std::log(1 - Rand() * exponentialCdf(mu, max));
+}
+/**
+ * Ziggurat method with 128 layers: most samples need one 64-bit random value,
+ * a table lookup, a multiplication and a comparison. Bits 57-63 select the
+ * layer, bit 56 the sign and bits 3-55 the position in the layer.
+ *
+ * REFERENCE: G. Marsaglia and W. W. Tsang (2000): The ziggurat method for
+ *            generating random variables, Journal of Statistical Software 5.
+ *
+ * @param mu Mean value of the gaussian distribution
+ * @param sigma Standard deviation of the gaussian distribution
+ * @return double value from gaussian distribution
+ */
+double SiPMRandom::randGaussian(const double mu, const double sigma) noexcept {
+  return standardGaussian() * sigma + mu;
+}
+
+/**
+ * Float version of @ref randGaussian
  */
 float SiPMRandom::randGaussianF(const float mu, const float sigma) noexcept {
-  static constexpr float kC1 = 1.448242853;
-  static constexpr float kC2 = 3.307147487;
-  static constexpr float kC3 = 1.46754004;
-  static constexpr float kD1 = 1.036467755;
-  static constexpr float kD2 = 5.295844968;
-  static constexpr float kD3 = 3.631288474;
-  static constexpr float kHm = 0.483941449;
-  static constexpr float kZm = 0.107981933;
-  static constexpr float kHp = 4.132731354;
-  static constexpr float kZp = 18.52161694;
-  static constexpr float kPhln = 0.4515827053;
-  static constexpr float kHm1 = 0.516058551;
-  static constexpr float kHp1 = 3.132731354;
-  static constexpr float kHzm = 0.375959516;
-  static constexpr float kHzmp = 0.591923442;
-  /*zhm 0.967882898*/
-
-  static constexpr float kAs = 0.8853395638;
-  static constexpr float kBs = 0.2452635696;
-  static constexpr float kCs = 0.2770276848;
-  static constexpr float kB = 0.5029324303;
-  static constexpr float kX0 = 0.4571828819;
-  static constexpr float kYm = 0.187308492;
-  static constexpr float kS = 0.7270572718;
-  static constexpr float kT = 0.03895759111;
-
-  do {
-    const float y = Rand<float>();
-
-    if (y > kHm1) {
-      const float result = kHp * y - kHp1;
-      return result * sigma + mu;
-    }
+  return static_cast<float>(standardGaussian()) * sigma + mu;
+}
 
-    if (y < kZm) {
-      const float rn = kZp * y - 1;
-      const float result = (rn > 0) ? (1 + rn) : (-1 + rn);
-      return result * sigma + mu;
-    }
+double SiPMRandom::standardGaussian() noexcept {
+  const uint64_t bits = next();
+  const uint32_t layer = bits >> 57;
+  const double x = ((bits >> 3) & 0x1fffffffffffff) * 0x1p-53 * kGaussianTable.x[layer];
+  const double sign = (bits >> 56) & 1 ? -1 : 1;
+  if (x < kGaussianTable.x[layer + 1]) {
+    return sign * x;
+  }
+  return sign * gaussianSlow(layer, x);
+}
 
-    if (y < kHm) {
-      const float rn = 2 * Rand<float>() - 1;
-      const float z = (rn > 0) ? 2 - rn : -2 - rn;
-      if ((kC1 - y) * (kC3 + abs(z)) < kC2) {
-        return z * sigma + mu;
-      }
-      const float x = rn * rn;
-      if ((y + kD1) * (kD3 + x) < kD2) {
-        return rn * sigma + mu;
-      }
-      if (kHzmp - y < exp(-(z * z + kPhln) * 0.5)) {
-        return z * sigma + mu;
-      }
-      if (y + kHzm < exp(-(x + kPhln) * 0.5)) {
-        return rn * sigma + mu;
-      }
-    }
+/**
+ * Samples outside the rectangle inside the curve are in the tail if the layer
+ * is the base one, otherwise they are accepted if they are below the curve.
+ * Tail is sampled with Marsaglia's method. Rejected samples are replaced by a
+ * new sample.
+ */
+double SiPMRandom::gaussianSlow(const uint32_t layer, const double x) noexcept {
+  if (layer == 0) {
+    constexpr double r = kGaussianTable.r;
+    double a, b;
+    do {
+      a = -std::log(1 - Rand()) / r;
+      b = -std::log(1 - Rand());
+    } while (2 * b < a * a);
+    return r + a;
+  }
+  const double f0 = kGaussianTable.f[layer];
+  const double f1 = kGaussianTable.f[layer + 1];
+  if (f0 + Rand() * (f1 - f0) < std::exp(-0.5 * x * x)) {
+    return x;
+  }
+  return standardGaussian();
+}
 
-    while (true) {
-      float x = Rand<float>();
-      float y = kYm * Rand<float>();
-      const float z = kX0 - kS * x - y;
-      float rn;
-      if (z > 0) {
-        rn = 2 + y / x;
-      } else {
-        x = 1 - x;
-        y = kYm - y;
-        rn = -(2 + y / x);
-      }
-      if ((y - kAs + x) * (kCs + x) + kBs < 0) {
-        return rn * sigma + mu;
-      }
-      if (y < x + kT) {
-        if (rn * rn < 4 * (kB - logf(x))) {
-          return rn * sigma + mu;
-        }
-      }
-    }
-  } while (false);
+double SiPMRandom::standardExponential() noexcept {
+  const uint64_t bits = next();
+  const uint32_t layer = bits >> 56;
+  const double x = ((bits >> 3) & 0x1fffffffffffff) * 0x1p-53 * kExponentialTable.x[layer];
+  if (x < kExponentialTable.x[layer + 1]) {
+    return x;
+  }
+  return exponentialSlow(layer, x);
+}
+
+/**
+ * Same as @ref gaussianSlow, the tail of the exponential is an exponential
+ * shifted by r.
+ */
+double SiPMRandom::exponentialSlow(const uint32_t layer, const double x) noexcept {
+  if (layer == 0) {
+    return kExponentialTable.r - std::log(1 - Rand());
+  }
+  const double f0 = kExponentialTable.f[layer];
+  const double f1 = kExponentialTable.f[layer + 1];
+  if (f0 + Rand() * (f1 - f0) < std::exp(-x)) {
+    return x;
+  }
+  return standardExponential();
 }
 
 /**
  * @param max Maximum value of integer to generate
  * @return uint32_t value from random integer distribution
  */
-uint32_t SiPMRandom::randInteger(const uint32_t max) noexcept { return ((m_rng() >> 32) * max) >> 32; }
+uint32_t SiPMRandom::randInteger(const uint32_t max) noexcept { return ((next() >> 32) * max) >> 32; }
 
 pair<uint32_t> SiPMRandom::randInteger2(const uint32_t max) noexcept {
-  const uint64_t u64 = m_rng();
+  const uint64_t u64 = next();
   // Use direct multiplication and bit-shifting
   // Use local variables to help compiler optimize
   uint32_t hi = static_cast<uint32_t>(u64 >> 32);
@@ -323,15 +637,23 @@ pair<uint32_t> SiPMRandom::randInteger2(const uint32_t max) noexcept {
  */
 std::vector<double> SiPMRandom::Rand(const uint32_t n) {
   std::vector<double> out(n);
+  Rand(n, out.data());
+  return out;
+}
+
+/**
+ * @param n Number of values to generate
+ * @param out Buffer of at least n doubles
+ */
+void SiPMRandom::Rand(const uint32_t n, double* out) noexcept {
   // Generate raw u64 directly into the output buffer (sizeof(uint64_t)==sizeof(double)),
   // then convert each element in-place before reading it as a double.
-  auto* const u64 = reinterpret_cast<uint64_t*>(out.data());
-  m_rng.getRand(u64, n);
+  auto* const u64 = reinterpret_cast<uint64_t*>(out);
+  fill(u64, n);
   for (uint32_t i = 0; i < n; ++i) {
     const uint64_t u = u64[i];
     out[i] = (u >> 11) * 0x1p-53;
   }
-  return out;
 }
 
 /**
@@ -339,15 +661,23 @@ std::vector<double> SiPMRandom::Rand(const uint32_t n) {
  */
 std::vector<float> SiPMRandom::RandF(const uint32_t n) {
   std::vector<float> out(n);
+  RandF(n, out.data());
+  return out;
+}
+
+/**
+ * @param n Number of values to generate
+ * @param out Buffer of at least n floats
+ */
+void SiPMRandom::RandF(const uint32_t n, float* out) noexcept {
   // Generate raw u32 directly into the output buffer (sizeof(uint32_t)==sizeof(float)),
   // then convert each element in-place before reading it as a float.
-  auto* const u32 = reinterpret_cast<uint32_t*>(out.data());
-  m_rng.getRand(u32, n);
+  auto* const u32 = reinterpret_cast<uint32_t*>(out);
+  fill(u32, n);
   for (uint32_t i = 0; i < n; ++i) {
     const uint32_t u = u32[i];
     out[i] = (u >> 8) * 0x1p-24f;
   }
-  return out;
 }
 
 /**
@@ -357,21 +687,29 @@ std::vector<float> SiPMRandom::RandF(const uint32_t n) {
  */
 std::vector<double> SiPMRandom::randGaussian(const double mu, const double sigma, const uint32_t n) {
   std::vector<double> out(n);
-  const std::vector<double> u = Rand(n);
+  fill(reinterpret_cast<uint64_t*>(out.data()), n);
   constexpr double TWO_PI = 2 * M_PI;
-
-  // Single pass: compute sqrtR once per pair, apply to both sin and cos outputs.
-  const uint32_t pairs = n & ~1u;
-  for (uint32_t i = 0; i < pairs; i += 2) {
-    const double sqrtR = sqrt(-2.0 * log(u[i]));
-    double s, c;
-#ifdef __APPLE__
-    __sincos(TWO_PI * u[i + 1], &s, &c);
-#else
-    sincos(TWO_PI * u[i + 1], &s, &c);
-#endif
-    out[i]     = s * sqrtR * sigma + mu;
-    out[i + 1] = c * sqrtR * sigma + mu;
+  constexpr uint32_t kChunk = 256;
+  double r[kChunk], phi[kChunk], s[kChunk], c[kChunk];
+
+  // Box-Muller as randGaussianF(const float, const float, const uint32_t, float*)
+  const uint32_t half = n / 2;
+  double* __restrict__ first = out.data();
+  double* __restrict__ second = out.data() + half;
+  for (uint32_t i = 0; i < half; i += kChunk) {
+    const uint32_t m = std::min(kChunk, half - i);
+    for (uint32_t j = 0; j < m; ++j) {
+      // First uniform in (0,1] to avoid log(0)
+      r[j] = 2 - unitInterval(first + i + j);
+      phi[j] = TWO_PI * (unitInterval(second + i + j) - 1);
+    }
+    SiPMMath::log(r, m, r);
+    SiPMMath::sincos(phi, m, s, c);
+    for (uint32_t j = 0; j < m; ++j) {
+      const double rho = std::sqrt(-2 * r[j]) * sigma;
+      first[i + j] = s[j] * rho + mu;
+      second[i + j] = c[j] * rho + mu;
+    }
   }
   if (n & 1u) {
     out[n - 1] = randGaussian(mu, sigma);
@@ -386,26 +724,53 @@ std::vector<double> SiPMRandom::randGaussian(const double mu, const double sigma
  */
 std::vector<float> SiPMRandom::randGaussianF(const float mu, const float sigma, const uint32_t n) {
   std::vector<float> out(n);
-  const std::vector<float> u = RandF(n);
-  constexpr float TWO_PI = 2 * M_PI;
+  randGaussianF(mu, sigma, n, out.data());
+  return out;
+}
 
-  // Single pass: compute sqrtR once per pair, apply to both sin and cos outputs.
-  const uint32_t pairs = n & ~1u;
-  for (uint32_t i = 0; i < pairs; i += 2) {
-    const float sqrtR = sqrtf(-2.0f * logf(u[i]));
-    float s, c;
-#ifdef __APPLE__
-    __sincosf(TWO_PI * u[i + 1], &s, &c);
-#else
-    sincosf(TWO_PI * u[i + 1], &s, &c);
-#endif
-    out[i]     = s * sqrtR * sigma + mu;
-    out[i + 1] = c * sqrtR * sigma + mu;
+/**
+ * Values are generated in place: random bits are written in the output buffer
+ * and then transformed using Box-Muller with the vectorized kernels of
+ * @ref SiPMMath, in chunks small enough to stay in L1 cache. The two values of
+ * each pair are stored at i and i + n / 2 so that all loads and stores are
+ * contiguous. This is faster than the ziggurat used by the scalar version,
+ * whose table lookups are not vectorized.
+ * @param mu Mean value of the gaussian
+ * @param sigma Standard deviation value of the gaussian
+ * @param n Number of values to generate
+ * @param out Buffer of at least n floats
+ */
+void SiPMRandom::randGaussianF(const float mu, const float sigma, const uint32_t n, float* out) noexcept {
+  uint32_t* const u32 = reinterpret_cast<uint32_t*>(out);
+  fill(u32, n);
+  constexpr float TWO_PI = 2 * M_PI;
+  constexpr uint32_t kChunk = 256;
+  float r[kChunk], phi[kChunk], s[kChunk], c[kChunk];
+
+  const uint32_t half = n / 2;
+  float* __restrict__ first = out;
+  float* __restrict__ second = out + half;
+  for (uint32_t i = 0; i < half; i += kChunk) {
+    const uint32_t m = std::min(kChunk, half - i);
+    for (uint32_t j = 0; j < m; ++j) {
+      uint32_t b0, b1;
+      std::memcpy(&b0, first + i + j, sizeof(b0));
+      std::memcpy(&b1, second + i + j, sizeof(b1));
+      // First uniform in (0,1] to avoid log(0)
+      r[j] = static_cast<float>((b0 >> 8) + 1) * 0x1p-24f;
+      phi[j] = static_cast<float>(b1 >> 8) * (0x1p-24f * TWO_PI);
+    }
+    SiPMMath::log(r, m, r);
+    SiPMMath::sincos(phi, m, s, c);
+    for (uint32_t j = 0; j < m; ++j) {
+      const float rho = sqrtf(-2.0f * r[j]) * sigma;
+      first[i + j] = s[j] * rho + mu;
+      second[i + j] = c[j] * rho + mu;
+    }
   }
   if (n & 1u) {
     out[n - 1] = randGaussianF(mu, sigma);
   }
-  return out;
 }
 
 /**
@@ -414,19 +779,23 @@ std::vector<float> SiPMRandom::randGaussianF(const float mu, const float sigma,
  */
 std::vector<uint32_t> SiPMRandom::randInteger(const uint32_t max, const uint32_t n) {
   std::vector<uint32_t> out(n);
+  randInteger(max, n, out.data());
+  return out;
+}
 
-  // Remember to free u32 ptr
-  uint32_t* u32 = (uint32_t*)sipmAlloc(sizeof(uint32_t) * n);
-  m_rng.getRand(u32, n);
+/**
+ * @param max Max value to generate
+ * @param n Number of values to generate
+ * @param out Buffer of at least n integers
+ */
+void SiPMRandom::randInteger(const uint32_t max, const uint32_t n, uint32_t* out) noexcept {
+  fill(out, n);
 
   // Sort of fixed point arithmetic
   // Avoids division and float numbers
   for (uint32_t i = 0; i < n; ++i) {
-    out[i] = (uint64_t(u32[i]) * max) >> 32;
+    out[i] = (uint64_t(out[i]) * max) >> 32;
   }
-  sipmFree(u32);
-
-  return out;
 }
 
 /**
@@ -435,10 +804,14 @@ std::vector<uint32_t> SiPMRandom::randInteger(const uint32_t max, const uint32_t
  */
 std::vector<double> SiPMRandom::randExponential(const double mu, const uint32_t n) {
   std::vector<double> out(n);
-  const std::vector<double> buffer = Rand(n);
-
+  fill(reinterpret_cast<uint64_t*>(out.data()), n);
+  // Inversion of the CDF with uniforms in (0,1] to avoid log(0)
+  for (uint32_t i = 0; i < n; ++i) {
+    out[i] = 2 - unitInterval(out.data() + i);
+  }
+  SiPMMath::log(out.data(), n, out.data());
   for (uint32_t i = 0; i < n; ++i) {
-    out[i] = -log(buffer[i]) * mu;
+    out[i] *= -mu;
   }
   return out;
 }
@@ -449,11 +822,80 @@ std::vector<double> SiPMRandom::randExponential(const double mu, const uint32_t
  */
 std::vector<float> SiPMRandom::randExponentialF(const float mu, const uint32_t n) {
   std::vector<float> out(n);
-  const std::vector<float> buffer = RandF(n);
+  randExponentialF(mu, n, out.data());
+  return out;
+}
 
+/**
+ * Inversion of the CDF, generated in place as
+ * @ref randGaussianF(const float, const float, const uint32_t, float*) and
+ * using the vectorized logarithm of @ref SiPMMath.
+ * @param mu Mean value of the exponential distribution
+ * @param n Number of values to generate
+ * @param out Buffer of at least n floats
+ */
+void SiPMRandom::randExponentialF(const float mu, const uint32_t n, float* out) noexcept {
+  uint32_t* const u32 = reinterpret_cast<uint32_t*>(out);
+  fill(u32, n);
   for (uint32_t i = 0; i < n; ++i) {
-    out[i] = -logf(buffer[i]) * mu;
+    uint32_t b;
+    std::memcpy(&b, out + i, sizeof(b));
+    // Uniform in (0,1] to avoid log(0)
+    out[i] = static_cast<float>((b >> 8) + 1) * 0x1p-24f;
+  }
+  SiPMMath::log(out, n, out);
+  for (uint32_t i = 0; i < n; ++i) {
+    out[i] *= -mu;
+  }
+}
+
+/**
+ * @param mu Mean value of the exponential distribution before truncation
+ * @param max Upper limit of the generated values
+ * @param n Number of values to generate
+ */
+std::vector<double> SiPMRandom::randExponentialTrunc(const double mu, const double max, const uint32_t n) {
+  std::vector<double> out(n);
+  Rand(n, out.data());
+  // Same for all values
+  const double scale = exponentialCdf(mu, max);
+  for (uint32_t i = 0; i < n; ++i) {
+    out[i] = 1 - out[i] * scale;
+  }
+  SiPMMath::log(out.data(), n, out.data());
+  for (uint32_t i = 0; i < n; ++i) {
+    out[i] *= -mu;
   }
   return out;
 }
+
+/**
+ * Truncation is computed for each value using the vectorized exponential and
+ * logarithm of @ref SiPMMath.
+ * @param mu Mean value of the exponential distribution of each value
+ * @param max Upper limit of each value
+ * @param n Number of values to generate
+ * @param out Buffer of at least n doubles, can be the same as mu or max
+ */
+void SiPMRandom::randExponentialTrunc(const double* mu, const double* max, const uint32_t n, double* out) noexcept {
+  constexpr uint32_t kChunk = 256;
+  double u[kChunk], tau[kChunk], cdf[kChunk];
+  for (uint32_t i = 0; i < n; i += kChunk) {
+    const uint32_t m = std::min(kChunk, n - i);
+    Rand(m, u);
+    for (uint32_t j = 0; j < m; ++j) {
+      tau[j] = mu[i + j];
+      // Same as exponentialCdf: exp(-40) is negligible with respect to 1
+      cdf[j] = -std::min(std::max(max[i + j], 0.0) / tau[j], 40.0);
+    }
+    SiPMMath::exp(cdf, m, cdf);
+    for (uint32_t j = 0; j < m; ++j) {
+      u[j] = 1 - u[j] * (1 - cdf[j]);
+    }
+    SiPMMath::log(u, m, u);
+    for (uint32_t j = 0; j < m; ++j) {
+      out[i + j] = -tau[j] * u[j];
+    }
+  }
+}
 } // namespace sipm
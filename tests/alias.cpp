@@ -0,0 +1,57 @@
+#include "SiPM.h"
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace sipm;
+
+struct TestSiPMAliasTable : public ::testing::Test {
+  static constexpr uint32_t N = 1000000;
+  SiPMRandom rng;
+};
+
+TEST_F(TestSiPMAliasTable, Empty) {
+  const SiPMAliasTable table;
+  EXPECT_TRUE(table.empty());
+  EXPECT_EQ(table.size(), 0);
+}
+
+TEST_F(TestSiPMAliasTable, Distribution) {
+  const std::vector<double> weights = {1, 0, 3, 0.5, 10, 0, 2.5, 3};
+  const SiPMAliasTable table(weights);
+  ASSERT_EQ(table.size(), weights.size());
+  double sum = 0;
+  for (const double w : weights) {
+    sum += w;
+  }
+
+  std::vector<uint32_t> countsScalar(weights.size());
+  std::vector<uint32_t> countsBulk(weights.size());
+  std::vector<uint32_t> bulk(N);
+  table.sample(rng, N, bulk.data());
+  for (uint32_t i = 0; i < N; ++i) {
+    countsScalar[table.sample(rng)]++;
+    ASSERT_LT(bulk[i], weights.size());
+    countsBulk[bulk[i]]++;
+  }
+  for (uint32_t i = 0; i < weights.size(); ++i) {
+    const double p = weights[i] / sum;
+    const double sigma = std::sqrt(N * p * (1 - p));
+    EXPECT_NEAR(countsScalar[i], N * p, 5 * sigma + 1e-9);
+    EXPECT_NEAR(countsBulk[i], N * p, 5 * sigma + 1e-9);
+  }
+}
+
+TEST_F(TestSiPMAliasTable, ZeroWeights) {
+  // All weights equal to 0 give a uniform distribution
+  const SiPMAliasTable table(std::vector<double>(4, 0));
+  std::vector<uint32_t> counts(4);
+  for (uint32_t i = 0; i < N; ++i) {
+    counts[table.sample(rng)]++;
+  }
+  for (const uint32_t c : counts) {
+    EXPECT_NEAR(c, N / 4, 5 * std::sqrt(N * 0.25 * 0.75));
+  }
+}
@@ -0,0 +1,125 @@
+#include "SiPM.h"
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace sipm;
+
+struct TestSiPMBatchRunner : public ::testing::Test {
+  static constexpr uint32_t nEvents = 1000;
+  static constexpr uint32_t nThreads = 4;
+  SiPMBatchRunner sut{SiPMProperties(), nThreads};
+  SiPMRandom rng;
+  std::vector<double> times;
+  std::vector<uint32_t> offsets;
+
+  void SetUp() override {
+    offsets.push_back(0);
+    for (uint32_t i = 0; i < nEvents; ++i) {
+      const std::vector<double> t = rng.randGaussian(10, 0.1, i % 50 + 1);
+      times.insert(times.end(), t.begin(), t.end());
+      offsets.push_back(times.size());
+    }
+  }
+};
+
+TEST_F(TestSiPMBatchRunner, Constructor) {
+  EXPECT_EQ(sut.nThreads(), nThreads);
+  SiPMBatchRunner runner;
+  EXPECT_GE(runner.nThreads(), 1);
+}
+
+TEST_F(TestSiPMBatchRunner, RunEvents) {
+  const uint32_t nSignalPoints = sut.properties().nSignalPoints();
+  std::vector<float> signals(nEvents * nSignalPoints);
+  std::vector<SiPMDebugInfo> debugs(nEvents);
+  sut.runEvents(times, offsets, signals.data(), debugs.data());
+  for (uint32_t i = 0; i < nEvents; ++i) {
+    EXPECT_EQ(debugs[i].nPhotons, i % 50 + 1);
+    EXPECT_GE(debugs[i].nPhotoelectrons, debugs[i].nPhotons);
+  }
+}
+
+TEST_F(TestSiPMBatchRunner, Reproducibility) {
+  const uint32_t nSignalPoints = sut.properties().nSignalPoints();
+  std::vector<float> first(nEvents * nSignalPoints);
+  std::vector<float> second(nEvents * nSignalPoints);
+  sut.seed(1234567890);
+  sut.runEvents(times, offsets, first.data());
+  sut.seed(1234567890);
+  sut.runEvents(times, offsets, second.data());
+  EXPECT_EQ(first, second);
+}
+
+TEST_F(TestSiPMBatchRunner, IndependentWorkers) {
+  auto prop = sut.properties();
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setDcrOff();
+  sut.setProperties(prop);
+  sut.seed(1234567890);
+  const uint32_t nSignalPoints = prop.nSignalPoints();
+  // Same event for all workers
+  const std::vector<double> t(nEvents, 10);
+  std::vector<uint32_t> off(nEvents + 1);
+  for (uint32_t i = 0; i <= nEvents; ++i) {
+    off[i] = i;
+  }
+  std::vector<float> signals(nEvents * nSignalPoints);
+  sut.runEvents(t, off, signals.data());
+  // Noise of events simulated by different workers must differ
+  const uint32_t eventsPerWorker = nEvents / nThreads;
+  for (uint32_t w = 1; w < nThreads; ++w) {
+    EXPECT_NE(signals[0], signals[w * eventsPerWorker * nSignalPoints]);
+  }
+}
+
+TEST_F(TestSiPMBatchRunner, CounterBasedEngine) {
+  // With a counter-based engine results do not depend on the number of threads
+  const uint32_t nSignalPoints = sut.properties().nSignalPoints();
+  std::vector<float> first(nEvents * nSignalPoints);
+  std::vector<float> second(nEvents * nSignalPoints);
+  SiPMBatchRunner single(sut.properties(), 1);
+  sut.setEngine(SiPMRandom::Engine::kPhilox4x32);
+  single.setEngine(SiPMRandom::Engine::kPhilox4x32);
+  sut.seed(1234567890);
+  single.seed(1234567890);
+  sut.runEvents(times, offsets, first.data());
+  single.runEvents(times, offsets, second.data());
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(sut.eventId(), nEvents);
+
+  // Single event can be simulated again using its id
+  SiPMEventContext context(1234567890, SiPMRandom::Engine::kPhilox4x32);
+  context.setEventId(123);
+  const SiPMModel& model = sut.model();
+  std::vector<float> event(nSignalPoints);
+  model.runEvents(context, times.data(), nullptr, offsets.data() + 123, 1, event.data());
+  EXPECT_TRUE(std::equal(event.begin(), event.end(), first.begin() + 123 * nSignalPoints));
+}
+
+TEST_F(TestSiPMBatchRunner, SeedBeforeEngine) {
+  // Seed is kept when the engine is changed after seeding
+  const uint32_t nSignalPoints = sut.properties().nSignalPoints();
+  std::vector<float> first(nEvents * nSignalPoints);
+  std::vector<float> second(nEvents * nSignalPoints);
+  SiPMBatchRunner single(sut.properties(), 1);
+  sut.seed(1234567890);
+  single.seed(1234567890);
+  sut.setEngine(SiPMRandom::Engine::kPhilox4x32);
+  single.setEngine(SiPMRandom::Engine::kPhilox4x32);
+  sut.runEvents(times, offsets, first.data());
+  single.runEvents(times, offsets, second.data());
+  EXPECT_EQ(first, second);
+
+  // Same results as seeding after setting the engine
+  single.seed(1234567890);
+  single.runEvents(times, offsets, second.data());
+  EXPECT_EQ(first, second);
+
+  // Event id is not changed by the engine
+  sut.setEngine(SiPMRandom::Engine::kXorshift256plus);
+  EXPECT_EQ(sut.eventId(), nEvents);
+}
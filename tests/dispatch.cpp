@@ -0,0 +1,142 @@
+#include "SiPM.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace sipm;
+using SiPMDispatch::Backend;
+
+struct TestSiPMDispatch : public ::testing::Test {
+  // Backends available on this machine
+  std::vector<Backend> backends() const {
+    std::vector<Backend> out;
+    for (const Backend b : {Backend::kScalar, Backend::kAVX2, Backend::kAVX512}) {
+      if (SiPMDispatch::isSupported(b)) {
+        out.push_back(b);
+      }
+    }
+    return out;
+  }
+
+  void TearDown() override { SiPMDispatch::setBackend(SiPMDispatch::bestBackend()); }
+};
+
+TEST_F(TestSiPMDispatch, Selection) {
+  // Fastest backend is selected when the library is loaded
+  EXPECT_EQ(SiPMDispatch::backend(), SiPMDispatch::bestBackend());
+  EXPECT_TRUE(SiPMDispatch::isSupported(Backend::kScalar));
+  for (const Backend b : {Backend::kScalar, Backend::kAVX2, Backend::kAVX512}) {
+    const Backend current = SiPMDispatch::backend();
+    if (SiPMDispatch::isSupported(b)) {
+      EXPECT_TRUE(SiPMDispatch::setBackend(b));
+      EXPECT_EQ(SiPMDispatch::backend(), b);
+    } else {
+      EXPECT_FALSE(SiPMDispatch::setBackend(b));
+      EXPECT_EQ(SiPMDispatch::backend(), current);
+    }
+  }
+  EXPECT_STREQ(SiPMDispatch::backendName(Backend::kScalar), "scalar");
+  EXPECT_STREQ(SiPMDispatch::backendName(Backend::kAVX2), "avx2");
+  EXPECT_STREQ(SiPMDispatch::backendName(Backend::kAVX512), "avx512");
+}
+
+TEST_F(TestSiPMDispatch, Xoshiro) {
+  static constexpr uint32_t n = 100;
+  uint64_t seed[4][8];
+  uint64_t x = 1234567890;
+  for (int i = 0; i < 4; ++i) {
+    for (int j = 0; j < 8; ++j) {
+      x = lcg64(x);
+      seed[i][j] = x;
+    }
+  }
+
+  // Reference xoshiro256+ for each lane
+  std::vector<uint64_t> expected(8 * n);
+  for (int j = 0; j < 8; ++j) {
+    uint64_t s[4] = {seed[0][j], seed[1][j], seed[2][j], seed[3][j]};
+    for (uint32_t k = 0; k < n; ++k) {
+      expected[8 * k + j] = s[0] + s[3];
+      const uint64_t t = s[1] << 17;
+      s[2] ^= s[0];
+      s[3] ^= s[1];
+      s[1] ^= s[2];
+      s[0] ^= s[3];
+      s[2] ^= t;
+      s[3] = (s[3] << 45) | (s[3] >> (64 - 45));
+    }
+  }
+
+  for (const Backend b : backends()) {
+    SiPMDispatch::setBackend(b);
+    uint64_t state[4][8];
+    std::memcpy(state, seed, sizeof(state));
+    // Unaligned output
+    std::vector<uint64_t> values(8 * n + 1);
+    SiPMDispatch::xoshiro256plus(state, values.data() + 1, n / 2);
+    SiPMDispatch::xoshiro256plus(state, values.data() + 1 + 4 * n, n - n / 2);
+    for (uint32_t i = 0; i < 8 * n; ++i) {
+      ASSERT_EQ(values[i + 1], expected[i]) << SiPMDispatch::backendName(b);
+    }
+  }
+}
+
+TEST_F(TestSiPMDispatch, Philox) {
+  const uint32_t counter[4] = {0xfffffff8, 7, 42, 1};
+  const uint32_t key[2] = {0x243f6a88, 0x85a308d3};
+  for (const Backend b : backends()) {
+    SiPMDispatch::setBackend(b);
+    uint32_t out[4][16];
+    SiPMDispatch::philox4x32(counter, key, out);
+    for (uint32_t l = 0; l < 16; ++l) {
+      const std::array<uint32_t, 4> block =
+        SiPMRng::Philox4x32::block({counter[0] + l, counter[1], counter[2], counter[3]}, {key[0], key[1]});
+      for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(out[i][l], block[i]) << SiPMDispatch::backendName(b);
+      }
+    }
+  }
+}
+
+TEST_F(TestSiPMDispatch, Accumulate) {
+  SiPMRandom rng(SiPMRandom::Engine::kXorshift256plus);
+  rng.seed(1234567890);
+  const std::vector<float> x = rng.RandF(1001);
+  const std::vector<float> y = rng.RandF(1001);
+  static constexpr float a = 1.7f;
+  for (const Backend b : backends()) {
+    SiPMDispatch::setBackend(b);
+    // Lengths not multiple of the vector size
+    for (const uint32_t n : {0u, 1u, 7u, 33u, 1001u}) {
+      std::vector<float> out(y);
+      SiPMDispatch::accumulate(out.data() + 1, x.data(), a, n - (n > 0));
+      EXPECT_EQ(out[0], y[0]);
+      for (uint32_t i = 1; i < n; ++i) {
+        EXPECT_NEAR(out[i], y[i] + a * x[i - 1], 1e-6f) << SiPMDispatch::backendName(b);
+      }
+      for (uint32_t i = std::max(n, 1u); i < out.size(); ++i) {
+        EXPECT_EQ(out[i], y[i]);
+      }
+    }
+  }
+}
+
+TEST_F(TestSiPMDispatch, SameStream) {
+  // Random streams must not depend on the backend
+  static constexpr uint32_t n = 1000;
+  std::vector<uint64_t> expected;
+  for (const Backend b : backends()) {
+    SiPMDispatch::setBackend(b);
+    SiPMRng::Xorshift256plus rng(1234567890);
+    std::vector<uint64_t> values(n);
+    rng.getRand(values.data(), n);
+    if (expected.empty()) {
+      expected = values;
+    } else {
+      EXPECT_EQ(values, expected) << SiPMDispatch::backendName(b);
+    }
+  }
+}
@@ -0,0 +1,53 @@
+#include "SiPM.h"
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+using namespace sipm;
+
+struct TestSiPMFft : public ::testing::Test {
+  SiPMRandom rng;
+};
+
+TEST_F(TestSiPMFft, NextPow2) {
+  EXPECT_EQ(SiPMFft::nextPow2(1), 1);
+  EXPECT_EQ(SiPMFft::nextPow2(3), 4);
+  EXPECT_EQ(SiPMFft::nextPow2(1000), 1024);
+  EXPECT_EQ(SiPMFft::nextPow2(1024), 1024);
+}
+
+TEST_F(TestSiPMFft, Forward) {
+  // Compare with naive DFT
+  const double pi = std::acos(-1.0);
+  for (uint32_t n : {2, 4, 8, 64, 256}) {
+    const SiPMFft fft(n);
+    const std::vector<double> x = rng.Rand(n);
+    std::vector<std::complex<double>> X(fft.nBins());
+    fft.forward(x.data(), X.data());
+    for (uint32_t k = 0; k < fft.nBins(); ++k) {
+      std::complex<double> expected = 0;
+      for (uint32_t j = 0; j < n; ++j) {
+        expected += x[j] * std::polar(1.0, -2 * pi * j * k / n);
+      }
+      EXPECT_NEAR(X[k].real(), expected.real(), 1e-9);
+      EXPECT_NEAR(X[k].imag(), expected.imag(), 1e-9);
+    }
+  }
+}
+
+TEST_F(TestSiPMFft, RoundTrip) {
+  for (uint32_t n : {2, 16, 1024, 1 << 15}) {
+    const SiPMFft fft(n);
+    const std::vector<double> x = rng.randGaussian(0, 1, n);
+    std::vector<std::complex<double>> X(fft.nBins());
+    std::vector<double> y(n);
+    fft.forward(x.data(), X.data());
+    fft.inverse(X.data(), y.data());
+    for (uint32_t i = 0; i < n; ++i) {
+      EXPECT_NEAR(x[i], y[i], 1e-9);
+    }
+  }
+}
@@ -0,0 +1,173 @@
+#include "SiPM.h"
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+using namespace sipm;
+using SiPMDispatch::Backend;
+
+struct TestSiPMMath : public ::testing::Test {
+  static constexpr uint32_t N = 1000003;
+
+  // Distance in ulp of a from the exact value b
+  static double ulp(const float a, const long double b) {
+    const int e = std::ilogb(static_cast<float>(b));
+    return std::fabs(static_cast<double>(a - b)) / std::ldexp(1.0, e - 23);
+  }
+  static double ulp(const double a, const long double b) {
+    const int e = std::ilogb(static_cast<double>(b));
+    return static_cast<double>(std::fabs(a - b) / std::ldexp(1.0L, e - 52));
+  }
+
+  // Values uniformly spaced in [a, b]
+  template <typename T>
+  static std::vector<T> range(const T a, const T b) {
+    std::vector<T> x(N);
+    for (uint32_t i = 0; i < N; ++i) {
+      // Rounding can exceed b with -ffast-math
+      x[i] = std::min(b, a + (b - a) * i / (N - 1));
+    }
+    return x;
+  }
+
+  // Backends available on this machine
+  std::vector<Backend> backends() const {
+    std::vector<Backend> out;
+    for (const Backend b : {Backend::kScalar, Backend::kAVX2, Backend::kAVX512}) {
+      if (SiPMDispatch::isSupported(b)) {
+        out.push_back(b);
+      }
+    }
+    return out;
+  }
+
+  void TearDown() override { SiPMDispatch::setBackend(SiPMDispatch::bestBackend()); }
+};
+
+TEST_F(TestSiPMMath, LogFloat) {
+  for (const Backend b : backends()) {
+    SiPMDispatch::setBackend(b);
+    // Mantissas near 1 and sqrt(2) and values spanning all exponents
+    for (auto x : {range(0.5f, 2.0f), range(1e-37f, 1e-30f), range(1.0f, 3e38f)}) {
+      std::vector<float> y(N);
+      SiPMMath::log(x.data(), N, y.data());
+      double maxUlp = 0;
+      for (uint32_t i = 0; i < N; ++i) {
+        if (x[i] == 1) {
+          EXPECT_EQ(y[i], 0);
+          continue;
+        }
+        maxUlp = std::max(maxUlp, ulp(y[i], std::log(static_cast<long double>(x[i]))));
+      }
+      EXPECT_LE(maxUlp, 1) << maxUlp << " " << SiPMDispatch::backendName(b);
+    }
+  }
+}
+
+TEST_F(TestSiPMMath, ExpFloat) {
+  for (const Backend b : backends()) {
+    SiPMDispatch::setBackend(b);
+    std::vector<float> x = range(-87.0f, 88.0f);
+    std::vector<float> y(N);
+    SiPMMath::exp(x.data(), N, y.data());
+    double maxUlp = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+      maxUlp = std::max(maxUlp, ulp(y[i], std::exp(static_cast<long double>(x[i]))));
+    }
+    EXPECT_LE(maxUlp, 1) << maxUlp << " " << SiPMDispatch::backendName(b);
+    // Outputs are clamped to normal numbers
+    const float big[3] = {-1000, 0, 1000};
+    float out[3];
+    SiPMMath::exp(big, 3, out);
+    EXPECT_GT(out[0], 0);
+    EXPECT_EQ(out[1], 1);
+    EXPECT_TRUE(std::isfinite(out[2]));
+  }
+}
+
+TEST_F(TestSiPMMath, SinCosFloat) {
+  for (const Backend b : backends()) {
+    SiPMDispatch::setBackend(b);
+    std::vector<float> x = range(-8192.0f, 8192.0f);
+    std::vector<float> s(N), c(N);
+    SiPMMath::sincos(x.data(), N, s.data(), c.data());
+    double maxError = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+      const long double xi = x[i];
+      maxError = std::max(maxError, static_cast<double>(std::fabs(s[i] - std::sin(xi))));
+      maxError = std::max(maxError, static_cast<double>(std::fabs(c[i] - std::cos(xi))));
+    }
+    EXPECT_LE(maxError, 1e-7) << maxError << " " << SiPMDispatch::backendName(b);
+  }
+}
+
+TEST_F(TestSiPMMath, LogDouble) {
+  for (const Backend b : backends()) {
+    SiPMDispatch::setBackend(b);
+    for (auto x : {range(0.5, 2.0), range(1e-307, 1e-300), range(1.0, 1e308)}) {
+      std::vector<double> y(N);
+      SiPMMath::log(x.data(), N, y.data());
+      double maxUlp = 0;
+      for (uint32_t i = 0; i < N; ++i) {
+        if (x[i] == 1) {
+          EXPECT_EQ(y[i], 0);
+          continue;
+        }
+        maxUlp = std::max(maxUlp, ulp(y[i], std::log(static_cast<long double>(x[i]))));
+      }
+      EXPECT_LE(maxUlp, 1) << maxUlp << " " << SiPMDispatch::backendName(b);
+    }
+  }
+}
+
+TEST_F(TestSiPMMath, ExpDouble) {
+  for (const Backend b : backends()) {
+    SiPMDispatch::setBackend(b);
+    std::vector<double> x = range(-708.0, 709.0);
+    std::vector<double> y(N);
+    SiPMMath::exp(x.data(), N, y.data());
+    double maxUlp = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+      maxUlp = std::max(maxUlp, ulp(y[i], std::exp(static_cast<long double>(x[i]))));
+    }
+    EXPECT_LE(maxUlp, 1.5) << maxUlp << " " << SiPMDispatch::backendName(b);
+  }
+}
+
+TEST_F(TestSiPMMath, SinCosDouble) {
+  for (const Backend b : backends()) {
+    SiPMDispatch::setBackend(b);
+    std::vector<double> x = range(-1e6, 1e6);
+    std::vector<double> s(N), c(N);
+    SiPMMath::sincos(x.data(), N, s.data(), c.data());
+    // Long double sin and cos can use x87 instructions with -ffast-math, that
+    // are less accurate than libm for large inputs. Bound includes the error of
+    // std::sin and std::cos
+    double maxError = 0;
+    for (uint32_t i = 0; i < N; ++i) {
+      maxError = std::max(maxError, std::fabs(s[i] - std::sin(x[i])));
+      maxError = std::max(maxError, std::fabs(c[i] - std::cos(x[i])));
+    }
+    EXPECT_LE(maxError, 3e-16) << maxError << " " << SiPMDispatch::backendName(b);
+  }
+}
+
+TEST_F(TestSiPMMath, InPlace) {
+  // Output can alias input and length needs not be a multiple of vector size
+  for (uint32_t n : {1, 7, 33}) {
+    std::vector<double> x = range(0.5, 2.0);
+    x.resize(n);
+    std::vector<double> y = x;
+    SiPMMath::log(x.data(), n, y.data());
+    SiPMMath::log(x.data(), n, x.data());
+    EXPECT_EQ(x, y);
+    SiPMMath::exp(x.data(), n, x.data());
+    for (uint32_t i = 0; i < n; ++i) {
+      EXPECT_NEAR(x[i], range(0.5, 2.0)[i], 1e-15);
+    }
+  }
+}
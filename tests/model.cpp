@@ -0,0 +1,620 @@
+#include "SiPM.h"
+#include <gtest/gtest.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace sipm;
+
+struct TestSiPMModel : public ::testing::Test {
+  static constexpr uint32_t nContexts = 4;
+  const SiPMModel sut;
+};
+
+TEST_F(TestSiPMModel, Constructor) {
+  EXPECT_EQ(sut.signalShape().size(), sut.properties().nSignalPoints());
+  SiPMProperties prop;
+  prop.setProperty("size", 3);
+  SiPMModel model(prop);
+  EXPECT_EQ(model.properties().size(), 3);
+}
+
+TEST_F(TestSiPMModel, RunEvent) {
+  SiPMEventContext context;
+  context.addPhotons(std::vector<double>(10, 10));
+  sut.runEvent(context);
+  EXPECT_EQ(context.signal().size(), sut.properties().nSignalPoints());
+  EXPECT_EQ(context.debug().nPhotons, 10);
+  EXPECT_EQ(context.hits().size(), context.debug().nPhotoelectrons + context.debug().nAp);
+
+  context.resetState();
+  EXPECT_EQ(context.hits().size(), 0);
+  EXPECT_EQ(context.debug().nPhotons, 0);
+}
+
+TEST_F(TestSiPMModel, SameAsSensor) {
+  SiPMSensor sensor;
+  SiPMEventContext context;
+  sensor.rng().seed(1234567890);
+  context.rng().seed(1234567890);
+
+  for (uint32_t i = 0; i < 100; ++i) {
+    sensor.resetState();
+    context.resetState();
+    sensor.addPhotons(std::vector<double>(i, 20));
+    context.addPhotons(std::vector<double>(i, 20));
+    sensor.runEvent();
+    sut.runEvent(context);
+    EXPECT_EQ(sensor.signal().waveform(), context.signal().waveform());
+  }
+}
+
+TEST_F(TestSiPMModel, SignalBufferReused) {
+  const SiPMModel model;
+  SiPMEventContext context;
+  model.runEvent(context);
+  const float* data = context.signal().waveform().data();
+  for (int i = 0; i < 10; ++i) {
+    context.resetState();
+    context.addPhotons({10, 20, 30});
+    model.runEvent(context);
+    EXPECT_EQ(context.signal().waveform().data(), data);
+    EXPECT_EQ(context.signal().size(), model.properties().nSignalPoints());
+  }
+}
+
+TEST_F(TestSiPMModel, SharedModel) {
+  // Same model used concurrently by many threads, each one with its own context
+  std::vector<SiPMEventContext> contexts;
+  std::vector<std::vector<float>> integrals(nContexts);
+  for (uint32_t i = 0; i < nContexts; ++i) {
+    contexts.emplace_back(1234567890);
+  }
+
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < nContexts; ++i) {
+    threads.emplace_back([&, i]() {
+      for (uint32_t j = 0; j < 100; ++j) {
+        contexts[i].resetState();
+        contexts[i].addPhotons(std::vector<double>(j, 20));
+        sut.runEvent(contexts[i]);
+        integrals[i].push_back(contexts[i].signal().integral(10, 250, 0));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Contexts have the same seed so they must give same results
+  for (uint32_t i = 1; i < nContexts; ++i) {
+    EXPECT_EQ(integrals[i], integrals[0]);
+  }
+}
+
+TEST_F(TestSiPMModel, CellRecovery) {
+  // Single cell sensor without noise: amplitude only depends on recovery
+  SiPMProperties prop;
+  prop.setProperty("size", 1);
+  prop.setProperty("pitch", 1000);
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setCcgv(0);
+  prop.setRecoveryTime(50);
+
+  for (uint32_t i = 0; i < 4; ++i) {
+    prop.setRecoveryMode(i % 2 ? SiPMProperties::RecoveryMode::kTimeSorted : SiPMProperties::RecoveryMode::kPerCell);
+    const SiPMModel model(prop);
+    SiPMEventContext context;
+    context.resetState();
+    context.addPhotons({80, 10, 60, 10});
+    model.runEvent(context);
+    const SiPMHitStore& hits = context.hits();
+    ASSERT_EQ(hits.size(), 4);
+    EXPECT_FLOAT_EQ(hits.amplitude(1), 1);
+    EXPECT_FLOAT_EQ(hits.amplitude(3), 0);
+    EXPECT_FLOAT_EQ(hits.amplitude(2), 1 - std::exp(-1.0));
+    EXPECT_FLOAT_EQ(hits.amplitude(0), 1 - std::exp(-20.0 / 50));
+  }
+}
+
+TEST_F(TestSiPMModel, RecoveryModes) {
+  // Both recovery algorithms must give same amplitudes
+  SiPMProperties prop;
+  prop.setProperty("size", 1);
+  prop.setProperty("pitch", 100);
+  SiPMProperties sortedProp = prop;
+  sortedProp.setRecoveryMode(SiPMProperties::RecoveryMode::kTimeSorted);
+  const SiPMModel perCell(prop);
+  const SiPMModel timeSorted(sortedProp);
+  SiPMEventContext first(1234567890);
+  SiPMEventContext second(1234567890);
+  SiPMRandom rng;
+
+  for (uint32_t nPhotons : {1, 10, 100, 1000, 10000}) {
+    const std::vector<double> times = rng.randGaussian(20, 5, nPhotons);
+    first.resetState();
+    second.resetState();
+    first.addPhotons(times);
+    second.addPhotons(times);
+    perCell.runEvent(first);
+    timeSorted.runEvent(second);
+    ASSERT_EQ(first.hits().size(), second.hits().size());
+    for (uint32_t i = 0; i < first.hits().size(); ++i) {
+      EXPECT_NEAR(first.hits().amplitude(i), second.hits().amplitude(i), 1e-5);
+    }
+    const std::vector<float>& a = first.signal().waveform();
+    const std::vector<float>& b = second.signal().waveform();
+    for (uint32_t i = 0; i < a.size(); ++i) {
+      EXPECT_NEAR(a[i], b[i], 1e-6 * (1 + nPhotons));
+    }
+  }
+}
+
+TEST_F(TestSiPMModel, RecursiveSignalEngine) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setCcgv(0);
+  prop.setProperty("snr", 200);
+  prop.setProperty("size", 3);
+  prop.setProperty("pitch", 10);
+
+  for (const bool slow : {false, true}) {
+    if (slow) {
+      prop.setSlowComponentOn();
+    }
+    SiPMProperties recursiveProp = prop;
+    recursiveProp.setSignalEngine(SiPMProperties::SignalEngine::kRecursive);
+    const SiPMModel direct(prop);
+    const SiPMModel recursive(recursiveProp);
+    SiPMEventContext first(1234567890);
+    SiPMEventContext second(1234567890);
+
+    // Hits on sampling points: same signal of direct engine
+    const std::vector<double> times = {10, 12, 100, 250, 251};
+    first.addPhotons(times);
+    second.addPhotons(times);
+    direct.runEvent(first);
+    recursive.runEvent(second);
+    const std::vector<float>& a = first.signal().waveform();
+    const std::vector<float>& b = second.signal().waveform();
+    ASSERT_EQ(a.size(), b.size());
+    for (uint32_t i = 0; i < a.size(); ++i) {
+      EXPECT_NEAR(a[i], b[i], 1e-4);
+    }
+  }
+}
+
+TEST_F(TestSiPMModel, RecursiveSubSampleTiming) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setCcgv(0);
+  prop.setProperty("snr", 200);
+  prop.setSignalEngine(SiPMProperties::SignalEngine::kRecursive);
+  const SiPMModel model(prop);
+  SiPMEventContext context;
+  context.addPhoton(10.3);
+  model.runEvent(context);
+
+  // Analytic shape evaluated at exact distance from hit time
+  const double tf = prop.fallingTimeFast();
+  const double tr = prop.risingTime();
+  auto shape = [=](const double x) { return std::exp(-x / tf) - std::exp(-x / tr); };
+  double peak = 0;
+  for (uint32_t i = 0; i < prop.nSignalPoints(); ++i) {
+    peak = std::max(peak, shape(i));
+  }
+  const std::vector<float>& signal = context.signal().waveform();
+  for (uint32_t i = 0; i < signal.size(); ++i) {
+    const double expected = i < 11 ? 0 : shape(i - 10.3) / peak * prop.gain();
+    EXPECT_NEAR(signal[i], expected, 1e-4);
+  }
+}
+
+TEST_F(TestSiPMModel, FftSignalEngine) {
+  SiPMProperties prop;
+  prop.setProperty("size", 3);
+  prop.setProperty("pitch", 10);
+  SiPMRandom rng;
+  const std::vector<double> times = rng.randGaussian(200, 100, 5000);
+
+  for (const auto engine : {SiPMProperties::SignalEngine::kFft, SiPMProperties::SignalEngine::kAuto}) {
+    SiPMProperties directProp = prop;
+    SiPMProperties fftProp = prop;
+    directProp.setSignalEngine(SiPMProperties::SignalEngine::kDirect);
+    fftProp.setSignalEngine(engine);
+    const SiPMModel direct(directProp);
+    const SiPMModel fft(fftProp);
+    SiPMEventContext first(1234567890);
+    SiPMEventContext second(1234567890);
+
+    // Same hits (noise included) and same truncation of hit times
+    first.addPhotons(times);
+    second.addPhotons(times);
+    direct.runEvent(first);
+    fft.runEvent(second);
+    const std::vector<float>& a = first.signal().waveform();
+    const std::vector<float>& b = second.signal().waveform();
+    ASSERT_EQ(first.hits().size(), second.hits().size());
+    ASSERT_EQ(a.size(), b.size());
+    // Direct engine accumulates in single precision
+    for (uint32_t i = 0; i < a.size(); ++i) {
+      EXPECT_NEAR(a[i], b[i], 1e-4 + 1e-5 * std::abs(a[i]));
+    }
+  }
+}
+
+TEST_F(TestSiPMModel, PulseTemplate) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setCcgv(0);
+  prop.setProperty("snr", 200);
+
+  // Analytic shape sampled every 10 ps used as measured template
+  const double tf = prop.fallingTimeFast();
+  const double tr = prop.risingTime();
+  auto shape = [=](const double x) { return std::exp(-x / tf) - std::exp(-x / tr); };
+  std::vector<double> pulse(50000);
+  for (uint32_t i = 0; i < pulse.size(); ++i) {
+    pulse[i] = shape(i * 0.01);
+  }
+  const double peak = *std::max_element(pulse.begin(), pulse.end());
+  prop.setPulseTemplate(pulse, 0.01);
+  EXPECT_EQ(prop.pulsePhases(), 100);
+
+  const SiPMModel model(prop);
+  SiPMEventContext context;
+  context.addPhoton(10.37);
+  model.runEvent(context);
+
+  const std::vector<float>& signal = context.signal().waveform();
+  for (uint32_t i = 0; i < signal.size(); ++i) {
+    const double expected = i < 11 ? 0 : shape(i - 10.37) / peak * prop.gain();
+    EXPECT_NEAR(signal[i], expected, 1e-4);
+  }
+}
+
+TEST_F(TestSiPMModel, NoiseBank) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setProperty("snr", 20);
+  const double rms = prop.snrLinear();
+
+  // Baseline statistics of generated noise and noise bank
+  auto stats = [](const SiPMModel& model, const uint32_t nEvents) {
+    SiPMEventContext context;
+    double mean = 0, var = 0, lag = 0;
+    uint32_t n = 0;
+    for (uint32_t e = 0; e < nEvents; ++e) {
+      context.resetState();
+      model.runEvent(context);
+      const std::vector<float>& x = context.signal().waveform();
+      for (uint32_t i = 0; i < x.size(); ++i) {
+        mean += x[i];
+        var += x[i] * x[i];
+        lag += i > 0 ? x[i] * x[i - 1] : 0;
+      }
+      n += x.size();
+    }
+    mean /= n;
+    var = var / n - mean * mean;
+    return std::vector<double>{mean, std::sqrt(var), (lag / n - mean * mean) / var};
+  };
+
+  const std::vector<double> generated = stats(SiPMModel(prop), 200);
+  prop.setNoiseMode(SiPMProperties::NoiseMode::kBank);
+  const std::vector<double> bank = stats(SiPMModel(prop), 200);
+  EXPECT_NEAR(generated[0], 0, 0.01 * rms);
+  EXPECT_NEAR(bank[0], 0, 0.01 * rms);
+  EXPECT_NEAR(generated[1], rms, 0.01 * rms);
+  EXPECT_NEAR(bank[1], rms, 0.01 * rms);
+  // Both white
+  EXPECT_NEAR(generated[2], 0, 0.01);
+  EXPECT_NEAR(bank[2], 0, 0.01);
+
+  // Low-pass spectrum: same RMS but correlated samples
+  prop.setNoiseSpectrum({0, 0.05, 0.1, 0.5}, {1, 1, 0, 0});
+  const std::vector<double> colored = stats(SiPMModel(prop), 200);
+  EXPECT_NEAR(colored[1], rms, 0.05 * rms);
+  EXPECT_GT(colored[2], 0.9);
+}
+
+TEST_F(TestSiPMModel, NoiseBankWindows) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setNoiseMode(SiPMProperties::NoiseMode::kBank);
+  prop.setNoiseBankSize(1024);
+  const SiPMModel model(prop);
+  SiPMEventContext context;
+
+  // Baselines are windows of the bank: few different baselines are possible
+  // and windows of different events overlap
+  std::set<float> firstSamples;
+  std::set<float> allSamples;
+  for (uint32_t e = 0; e < 5000; ++e) {
+    context.resetState();
+    model.runEvent(context);
+    const std::vector<float>& x = context.signal().waveform();
+    firstSamples.insert(x[0]);
+    allSamples.insert(x.begin(), x.end());
+  }
+  EXPECT_LE(firstSamples.size(), 1024);
+  EXPECT_LE(allSamples.size(), 1024);
+}
+
+TEST_F(TestSiPMModel, SpectrumPde) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setProperty("size", 10);
+  const std::vector<double> wlen = {300, 400, 500, 600, 700};
+  const std::vector<double> pde = {0.1, 0.3, 0.2, 0.1, 0.05};
+
+  for (const uint32_t nPoints : {32, 100}) {
+    prop.setPdeSpectrum(wlen, pde, nPoints);
+    // Reference value from linear interpolation of the resampled spectrum
+    const std::map<double, double>& spectrum = prop.pdeSpectrum();
+    auto it1 = spectrum.upper_bound(455);
+    auto it0 = std::prev(it1);
+    const double expected =
+      it0->second + (it1->second - it0->second) * (455 - it0->first) / (it1->first - it0->first);
+
+    const SiPMModel model(prop);
+    SiPMEventContext context;
+    const uint32_t n = 100000;
+    context.addPhotons(std::vector<double>(n, 100), std::vector<double>(n, 455));
+    model.runEvent(context);
+    const double sigma = std::sqrt(n * expected * (1 - expected));
+    EXPECT_NEAR(context.debug().nPhotoelectrons, n * expected, 4 * sigma);
+
+    // Outside of the spectrum PDE is extrapolated and never negative
+    context.resetState();
+    context.addPhotons(std::vector<double>(1000, 100), std::vector<double>(1000, 2000));
+    model.runEvent(context);
+    EXPECT_EQ(context.debug().nPhotoelectrons, 0);
+  }
+}
+
+TEST_F(TestSiPMModel, BinomialPde) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setProperty("size", 10);
+  prop.setPdeSampling(SiPMProperties::PdeSampling::kBinomial);
+  const uint32_t n = 1000;
+  const uint32_t nEvents = 2000;
+  std::vector<double> times(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    times[i] = 0.4 * i;
+  }
+
+  for (const double pde : {0.01, 0.3, 0.8}) {
+    prop.setPde(pde);
+    const SiPMModel model(prop);
+    SiPMEventContext context;
+    double mean = 0;
+    double var = 0;
+    double meanTime = 0;
+    for (uint32_t i = 0; i < nEvents; ++i) {
+      context.resetState();
+      context.addPhotons(times);
+      model.runEvent(context);
+      const double nPe = context.debug().nPhotoelectrons;
+      mean += nPe;
+      var += nPe * nPe;
+      for (const SiPMHit hit : context.hits()) {
+        meanTime += hit.time();
+      }
+    }
+    meanTime /= mean;
+    mean /= nEvents;
+    var = var / nEvents - mean * mean;
+    const double expVar = n * pde * (1 - pde);
+    EXPECT_NEAR(mean, n * pde, 4 * std::sqrt(expVar / nEvents));
+    EXPECT_NEAR(var / expVar, 1, 0.15);
+    // All photons are equally likely to be detected
+    EXPECT_NEAR(meanTime, 0.4 * (n - 1) / 2, 4 * 115 / std::sqrt(mean * nEvents));
+  }
+}
+
+TEST_F(TestSiPMModel, CircleHitDistribution) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setHitDistribution(SiPMProperties::HitDistribution::kCircle);
+  const SiPMModel model(prop);
+  SiPMEventContext context;
+  const uint32_t n = 100000;
+  context.addPhotons(std::vector<double>(n, 100));
+  model.runEvent(context);
+  const double half = prop.nSideCells() / 2.0;
+  uint32_t nInside = 0;
+  for (const SiPMHit hit : context.hits()) {
+    const double x = (hit.row() + 0.5 - half) / half;
+    const double y = (hit.col() + 0.5 - half) / half;
+    nInside += x * x + y * y <= 1;
+  }
+  // 90% of photons in the circle, up to cells on the border
+  EXPECT_NEAR(static_cast<double>(nInside) / n, 0.9, 0.02);
+}
+
+TEST_F(TestSiPMModel, CustomHitMap) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  // Light only on the first row and last column of a 2x2 map
+  prop.setHitMap({0, 1, 0, 0}, 2, 2);
+  EXPECT_TRUE(prop.hitDistribution() == SiPMProperties::HitDistribution::kCustomMap);
+  const SiPMModel model(prop);
+  SiPMEventContext context;
+  const uint32_t n = 10000;
+  context.addPhotons(std::vector<double>(n, 100));
+  model.runEvent(context);
+  const uint32_t half = prop.nSideCells() / 2;
+  std::set<uint32_t> cells;
+  for (const SiPMHit hit : context.hits()) {
+    EXPECT_LT(hit.row(), half);
+    EXPECT_GE(hit.col(), half);
+    cells.insert(hit.row() * prop.nSideCells() + hit.col());
+  }
+  // All cells of the quadrant are hit
+  EXPECT_EQ(cells.size(), half * half);
+
+  // Map with the same resolution of the cells
+  const uint32_t nSide = prop.nSideCells();
+  std::vector<double> map(nSide * nSide, 0);
+  map[3 * nSide + 7] = 1;
+  map[10 * nSide + 2] = 3;
+  prop.setHitMap(map, nSide, nSide);
+  const SiPMModel cellModel(prop);
+  context.resetState();
+  context.addPhotons(std::vector<double>(n, 100));
+  cellModel.runEvent(context);
+  uint32_t nFirst = 0;
+  for (const SiPMHit hit : context.hits()) {
+    const bool first = hit.row() == 3 && hit.col() == 7;
+    EXPECT_TRUE(first || (hit.row() == 10 && hit.col() == 2));
+    nFirst += first;
+  }
+  EXPECT_NEAR(nFirst, n / 4, 5 * std::sqrt(n * 0.25 * 0.75));
+}
+
+TEST_F(TestSiPMModel, CustomHitMapWithoutMap) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  // Distribution selected without a map gives uniform hits
+  prop.setHitDistribution(SiPMProperties::HitDistribution::kCustomMap);
+  const SiPMModel model(prop);
+  SiPMEventContext context;
+  const uint32_t n = 10000;
+  context.addPhotons(std::vector<double>(n, 100));
+  model.runEvent(context);
+  const uint32_t half = prop.nSideCells() / 2;
+  uint32_t quadrants[4] = {};
+  for (const SiPMHit hit : context.hits()) {
+    ++quadrants[2 * (hit.row() >= half) + (hit.col() >= half)];
+  }
+  const double nHits = context.hits().size();
+  EXPECT_GT(nHits, 0);
+  for (const uint32_t q : quadrants) {
+    EXPECT_NEAR(q, nHits / 4, 5 * std::sqrt(nHits * 0.25 * 0.75));
+  }
+}
+
+TEST_F(TestSiPMModel, BulkDcr) {
+  SiPMProperties prop;
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setDcr(10e6);
+  prop.setSignalLength(10000);
+  const SiPMModel model(prop);
+  SiPMEventContext context;
+  const uint32_t nEvents = 1000;
+  // 100 dark counts per event on average
+  const double mu = prop.dcr() * prop.signalLength() * 1e-9;
+  double mean = 0;
+  double var = 0;
+  double meanTime = 0;
+  for (uint32_t i = 0; i < nEvents; ++i) {
+    context.resetState();
+    model.runEvent(context);
+    const double nDcr = context.debug().nDcr;
+    mean += nDcr;
+    var += nDcr * nDcr;
+    for (const SiPMHit hit : context.hits()) {
+      EXPECT_TRUE(hit.hitType() == SiPMHit::HitType::kDarkCount);
+      EXPECT_GE(hit.time(), 0);
+      EXPECT_LE(hit.time(), prop.signalLength());
+      EXPECT_LT(hit.row(), prop.nSideCells());
+      EXPECT_LT(hit.col(), prop.nSideCells());
+      meanTime += hit.time();
+    }
+  }
+  meanTime /= mean;
+  mean /= nEvents;
+  var = var / nEvents - mean * mean;
+  EXPECT_NEAR(mean, mu, 4 * std::sqrt(mu / nEvents));
+  EXPECT_NEAR(var / mu, 1, 0.15);
+  // Times are uniform in the signal window
+  const double sigmaTime = prop.signalLength() / std::sqrt(12 * mean * nEvents);
+  EXPECT_NEAR(meanTime, prop.signalLength() / 2, 4 * sigmaTime);
+}
+
+TEST_F(TestSiPMModel, CascadeStatistics) {
+  SiPMProperties prop;
+  prop.setDcr(10e6);
+  prop.setSignalLength(10000);
+  prop.setSize(1);
+  prop.setPitch(100);
+  prop.setXt(0.2);
+  prop.setDXt(0.3);
+  prop.setAp(0.1);
+  const SiPMModel model(prop);
+  SiPMEventContext context;
+  const uint32_t nEvents = 200;
+  double nHits = 0;
+  double nXt = 0;
+  double nDXt = 0;
+  double nAp = 0;
+  for (uint32_t i = 0; i < nEvents; ++i) {
+    context.resetState();
+    model.runEvent(context);
+    const SiPMDebugInfo debug = context.debug();
+    const SiPMHitStore& hits = context.hits();
+    nHits += hits.size();
+    nXt += debug.nXt;
+    nDXt += debug.nDXt;
+    nAp += debug.nAp;
+    for (uint32_t j = 0; j < hits.size(); ++j) {
+      EXPECT_LE(hits.time(j), prop.signalLength());
+      EXPECT_LT(hits.row(j), prop.nSideCells());
+      EXPECT_LT(hits.col(j), prop.nSideCells());
+      if (hits.hitType(j) == SiPMHit::HitType::kDarkCount) {
+        continue;
+      }
+      // Children come after their parent
+      const int32_t parent = hits.parent(j);
+      ASSERT_GE(parent, 0);
+      ASSERT_LT(parent, static_cast<int32_t>(j));
+      EXPECT_GE(hits.time(j), hits.time(parent));
+      const int32_t dr = static_cast<int32_t>(hits.row(j)) - static_cast<int32_t>(hits.row(parent));
+      const int32_t dc = static_cast<int32_t>(hits.col(j)) - static_cast<int32_t>(hits.col(parent));
+      if (hits.hitType(j) == SiPMHit::HitType::kOpticalCrosstalk) {
+        EXPECT_EQ(hits.time(j), hits.time(parent));
+      }
+      if (hits.hitType(j) == SiPMHit::HitType::kFastAfterPulse ||
+          hits.hitType(j) == SiPMHit::HitType::kSlowAfterPulse) {
+        EXPECT_EQ(dr, 0);
+        EXPECT_EQ(dc, 0);
+      } else {
+        // Crosstalk in one of the 8 neighbours
+        EXPECT_LE(std::abs(dr), 1);
+        EXPECT_LE(std::abs(dc), 1);
+        EXPECT_TRUE(dr != 0 || dc != 0);
+      }
+    }
+  }
+  // Each hit generates on average xt crosstalk and ap afterpulses
+  EXPECT_NEAR(nXt / nHits, prop.xt(), 4 * std::sqrt(prop.xt() / nHits));
+  EXPECT_NEAR(nAp / nHits, prop.ap(), 4 * std::sqrt(prop.ap() / nHits));
+  EXPECT_NEAR(nDXt / nXt, prop.dxt(), 4 * std::sqrt(prop.dxt() / nXt));
+}
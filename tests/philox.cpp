@@ -0,0 +1,74 @@
+#include "SiPM.h"
+#include <array>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <vector>
+
+using namespace sipm;
+
+struct TestSiPMPhilox : public ::testing::Test {};
+
+TEST_F(TestSiPMPhilox, KnownAnswer) {
+  // Known answer tests from Random123 distribution
+  using SiPMRng::Philox4x32;
+  const std::array<uint32_t, 4> zero = Philox4x32::block({0, 0, 0, 0}, {0, 0});
+  const std::array<uint32_t, 4> ones =
+    Philox4x32::block({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff});
+  const std::array<uint32_t, 4> pi =
+    Philox4x32::block({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0});
+  EXPECT_EQ(zero, (std::array<uint32_t, 4>{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+  EXPECT_EQ(ones, (std::array<uint32_t, 4>{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+  EXPECT_EQ(pi, (std::array<uint32_t, 4>{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+TEST_F(TestSiPMPhilox, BlockGeneration) {
+  // Vectorized generation must match single block evaluation
+  static constexpr uint64_t seed = 1234567890;
+  static constexpr uint32_t n = 1000;
+  SiPMRng::Philox4x32 rng(seed);
+  rng.setStream(42, 7);
+  std::vector<uint64_t> values(n);
+  rng.getRand(values.data(), n);
+  for (uint32_t i = 0; i < n; i += 2) {
+    const std::array<uint32_t, 4> block =
+      SiPMRng::Philox4x32::block({i / 2, 7, 42, 0}, {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)});
+    EXPECT_EQ(values[i], (static_cast<uint64_t>(block[1]) << 32) | block[0]);
+    EXPECT_EQ(values[i + 1], (static_cast<uint64_t>(block[3]) << 32) | block[2]);
+  }
+
+  // Buffered generation gives the same stream
+  rng.setStream(42, 7);
+  for (uint32_t i = 0; i < n; ++i) {
+    EXPECT_EQ(rng(), values[i]);
+  }
+
+  // 32 bits generation uses the same blocks
+  std::vector<uint32_t> values32(2 * n);
+  rng.setStream(42, 7);
+  rng.getRand(values32.data(), 2 * n);
+  for (uint32_t i = 0; i < n; ++i) {
+    EXPECT_EQ((static_cast<uint64_t>(values32[2 * i + 1]) << 32) | values32[2 * i], values[i]);
+  }
+}
+
+TEST_F(TestSiPMPhilox, Streams) {
+  static constexpr uint32_t n = 1024;
+  SiPMRng::Philox4x32 rng(1234567890);
+  std::vector<uint64_t> first(n), second(n), third(n);
+  rng.setStream(1, 0);
+  rng.getRand(first.data(), n);
+  rng.setStream(2, 0);
+  rng.getRand(second.data(), n);
+  rng.setStream(1, 1);
+  rng.getRand(third.data(), n);
+  for (uint32_t i = 0; i < n; ++i) {
+    EXPECT_NE(first[i], second[i]);
+    EXPECT_NE(first[i], third[i]);
+  }
+
+  // Going back to a stream gives the same values
+  rng.setStream(1, 0);
+  for (uint32_t i = 0; i < n; ++i) {
+    EXPECT_EQ(rng(), first[i]);
+  }
+}
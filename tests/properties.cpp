@@ -74,6 +74,24 @@ TEST_F(TestSiPMProperties, SetHitDistribution) {
   EXPECT_TRUE(lsut.hitDistribution() == SiPMProperties::HitDistribution::kCircle);
 }
 
+TEST_F(TestSiPMProperties, InvalidHitMap) {
+  SiPMProperties lsut = sut;
+  lsut.setHitMap({0, 1, 0, 0}, 2, 2);
+  EXPECT_TRUE(lsut.hitDistribution() == SiPMProperties::HitDistribution::kCustomMap);
+  // Maps without bins or with a wrong size fall back to uniform hits
+  for (const auto& map : {std::vector<double>{}, std::vector<double>{1, 2, 3}}) {
+    lsut.setHitMap(map, 2, 2);
+    EXPECT_TRUE(lsut.hitDistribution() == SiPMProperties::HitDistribution::kUniform);
+    EXPECT_TRUE(lsut.hitMap().empty());
+  }
+  lsut.setHitMap({}, 0, 0);
+  EXPECT_TRUE(lsut.hitDistribution() == SiPMProperties::HitDistribution::kUniform);
+  lsut.setHitMap({1, 2, 3, 4, 5}, 2, 2);
+  EXPECT_TRUE(lsut.hitDistribution() == SiPMProperties::HitDistribution::kUniform);
+  EXPECT_EQ(lsut.hitMapRows(), 0);
+  EXPECT_EQ(lsut.hitMapCols(), 0);
+}
+
 TEST_F(TestSiPMProperties, SetHitPdeType) {
   SiPMProperties lsut = sut;
   lsut.setPdeType(SiPMProperties::PdeType::kNoPde);
@@ -85,3 +103,15 @@ TEST_F(TestSiPMProperties, SetHitPdeType) {
   lsut.setPde(0.3);
   EXPECT_DOUBLE_EQ(lsut.pde(), 0.3);
 }
+
+TEST_F(TestSiPMProperties, PdeSpectrumResolution) {
+  SiPMProperties lsut = sut;
+  const std::vector<double> wlen = {300, 400, 500, 600, 700};
+  const std::vector<double> pde = {0.1, 0.3, 0.2, 0.1, 0.05};
+  lsut.setPdeSpectrum(wlen, pde);
+  EXPECT_EQ(lsut.pdeSpectrum().size(), SiPMProperties::kPdeSpectrumPoints);
+  EXPECT_TRUE(lsut.pdeType() == SiPMProperties::PdeType::kSpectrumPde);
+  lsut.setPdeSpectrum(wlen, pde, 256);
+  EXPECT_EQ(lsut.pdeSpectrum().size(), 256);
+  EXPECT_DOUBLE_EQ(lsut.pdeSpectrum().begin()->first, 300);
+}
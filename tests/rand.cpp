@@ -3,6 +3,10 @@
 #include <math.h>
 #include <stdint.h>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 using namespace sipm;
 
 struct TestSiPMRandom : public ::testing::Test {
@@ -141,6 +145,49 @@ TEST_F(TestSiPMRandom, ExponentialAverageBig) {
   EXPECT_LE(x, muBig + 3 * std);
 }
 
+TEST_F(TestSiPMRandom, ExponentialTruncated) {
+  sipm::SiPMRandom rng;
+  // Mean of an exponential truncated at max
+  auto truncatedMean = [](const double mu, const double max) {
+    return mu - max * std::exp(-max / mu) / (1 - std::exp(-max / mu));
+  };
+  for (const double max : {0.1 * muBig, muBig, 10 * muBig}) {
+    double x = 0;
+    for (int i = 0; i < N; ++i) {
+      const double y = rng.randExponentialTrunc(muBig, max);
+      ASSERT_GE(y, 0);
+      ASSERT_LE(y, max);
+      x += y;
+    }
+    x = x / N;
+    // Standard deviation is at most the one of a uniform in [0, max]
+    const double std = std::min(muBig, max / std::sqrt(12)) / std::sqrt(N);
+    EXPECT_NEAR(x, truncatedMean(muBig, max), 4 * std);
+  }
+  // Vector versions
+  const int n = N / 100;
+  const double max = 0.5 * muSmall;
+  const std::vector<double> v = rng.randExponentialTrunc(muSmall, max, n);
+  const std::vector<double> mu(n, muSmall);
+  std::vector<double> w(n, max);
+  rng.randExponentialTrunc(mu.data(), w.data(), n, w.data());
+  double xv = 0;
+  double xw = 0;
+  for (int i = 0; i < n; ++i) {
+    ASSERT_GE(v[i], 0);
+    ASSERT_LE(v[i], max);
+    ASSERT_GE(w[i], 0);
+    ASSERT_LE(w[i], max);
+    xv += v[i];
+    xw += w[i];
+  }
+  const double std = max / std::sqrt(12 * n);
+  EXPECT_NEAR(xv / n, truncatedMean(muSmall, max), 4 * std);
+  EXPECT_NEAR(xw / n, truncatedMean(muSmall, max), 4 * std);
+  // Truncation at 0 or below gives 0
+  EXPECT_EQ(rng.randExponentialTrunc(muSmall, -1), 0);
+}
+
 TEST_F(TestSiPMRandom, PoissonAverageSmall) {
   sipm::SiPMRandom rng;
   double x = 0;
@@ -187,6 +234,193 @@ TEST_F(TestSiPMRandom, NormalAverageBig) {
   EXPECT_LE(x, 3 * muBig);
 }
 
+TEST_F(TestSiPMRandom, NormalFBuffer) {
+  sipm::SiPMRandom rng;
+  // Odd size to test the last value
+  const uint32_t n = 100001;
+  std::vector<float> x(n);
+  rng.randGaussianF(1, 2, n, x.data());
+  double mean = 0;
+  double var = 0;
+  double cov = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    mean += x[i];
+  }
+  mean /= n;
+  for (uint32_t i = 0; i < n; ++i) {
+    var += (x[i] - mean) * (x[i] - mean);
+  }
+  var /= n;
+  // Values of the same Box-Muller pair
+  for (uint32_t i = 0; i < n / 2; ++i) {
+    cov += (x[i] - mean) * (x[i + n / 2] - mean);
+  }
+  cov /= n / 2;
+  EXPECT_NEAR(mean, 1, 0.05);
+  EXPECT_NEAR(var, 4, 0.1);
+  EXPECT_NEAR(cov / var, 0, 0.02);
+}
+
+// Largest distance between the empirical CDF of the values and the expected
+// one, times sqrt(n). Kolmogorov test at 0.1% gives 1.95
+template <typename T, typename Cdf>
+static double kolmogorovDistance(std::vector<T> x, Cdf cdf) {
+  std::sort(x.begin(), x.end());
+  const double n = x.size();
+  double d = 0;
+  for (uint32_t i = 0; i < x.size(); ++i) {
+    const double f = cdf(x[i]);
+    d = std::max({d, f - i / n, (i + 1) / n - f});
+  }
+  return d * std::sqrt(n);
+}
+
+TEST_F(TestSiPMRandom, ZigguratGaussian) {
+  sipm::SiPMRandom rng;
+  // Fixed seed, the bounds of the tests are exceeded once every ~1000 runs
+  rng.seed(1234567890);
+  const uint32_t n = 1000000;
+  auto cdf = [](const double x) { return 0.5 * std::erfc(-x / std::sqrt(2)); };
+  std::vector<double> scalar(n);
+  std::vector<float> scalarF(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    scalar[i] = rng.randGaussian(0, 1);
+    scalarF[i] = rng.randGaussianF(0, 1);
+  }
+  EXPECT_LT(kolmogorovDistance(scalar, cdf), 1.95);
+  EXPECT_LT(kolmogorovDistance(scalarF, cdf), 1.95);
+  EXPECT_LT(kolmogorovDistance(rng.randGaussian(0, 1, n), cdf), 1.95);
+  EXPECT_LT(kolmogorovDistance(rng.randGaussianF(0, 1, n), cdf), 1.95);
+
+  // Tail beyond the base layer of the ziggurat
+  const double r = 3.442619855899;
+  const std::vector<float> x = rng.randGaussianF(0, 1, n);
+  const double expected = n * std::erfc(r / std::sqrt(2));
+  const double tail = std::count_if(x.begin(), x.end(), [r](const float v) { return std::fabs(v) > r; });
+  EXPECT_NEAR(tail, expected, 4 * std::sqrt(expected));
+}
+
+TEST_F(TestSiPMRandom, ZigguratExponential) {
+  sipm::SiPMRandom rng;
+  // Fixed seed, the bounds of the tests are exceeded once every ~1000 runs
+  rng.seed(1234567890);
+  const uint32_t n = 1000000;
+  auto cdf = [](const double x) { return 1 - std::exp(-x); };
+  std::vector<double> scalar(n);
+  std::vector<float> scalarF(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    scalar[i] = rng.randExponential(1);
+    scalarF[i] = rng.randExponentialF(1);
+  }
+  EXPECT_LT(kolmogorovDistance(scalar, cdf), 1.95);
+  EXPECT_LT(kolmogorovDistance(scalarF, cdf), 1.95);
+  EXPECT_LT(kolmogorovDistance(rng.randExponential(1, n), cdf), 1.95);
+  EXPECT_LT(kolmogorovDistance(rng.randExponentialF(1, n), cdf), 1.95);
+
+  // Tail beyond the base layer of the ziggurat
+  const double r = 7.69711747013104972;
+  const std::vector<float> x = rng.randExponentialF(1, n);
+  const double expected = n * std::exp(-r);
+  const double tail = std::count_if(x.begin(), x.end(), [r](const float v) { return v > r; });
+  EXPECT_NEAR(tail, expected, 4 * std::sqrt(expected));
+}
+
+TEST_F(TestSiPMRandom, PoissonDistribution) {
+  sipm::SiPMRandom rng;
+  const int M = 1000000;
+  // Multiplication method and PTRS
+  for (const double mu : {5.0, 50.0, 1000.0}) {
+    std::vector<uint32_t> counts(static_cast<uint32_t>(3 * mu) + 100);
+    double var = 0;
+    for (int i = 0; i < M; ++i) {
+      const uint32_t x = rng.randPoisson(mu);
+      if (x < counts.size()) {
+        counts[x]++;
+      }
+      var += (x - mu) * (x - mu);
+    }
+    EXPECT_NEAR(var / M / mu, 1, 0.01);
+    // Compare with the exact pmf around the mean
+    const uint32_t kmin = std::max(0.0, mu - 3 * std::sqrt(mu));
+    const uint32_t kmax = mu + 3 * std::sqrt(mu);
+    for (uint32_t k = kmin; k <= kmax; ++k) {
+      const double pmf = std::exp(-mu + k * std::log(mu) - std::lgamma(k + 1));
+      EXPECT_NEAR(counts[k], M * pmf, 5 * std::sqrt(M * pmf) + 1) << "mu = " << mu << " k = " << k;
+    }
+  }
+}
+
+TEST_F(TestSiPMRandom, BinomialAverage) {
+  sipm::SiPMRandom rng;
+  const int M = 200000;
+  // Inversion and BTPE, with p below and above 0.5
+  const std::vector<std::pair<uint32_t, double>> params = {{50, 0.1}, {200, 0.97}, {1000, 0.3}, {100000, 0.9}};
+  for (const auto& [n, p] : params) {
+    double mean = 0;
+    double var = 0;
+    std::vector<uint32_t> x(M);
+    for (int i = 0; i < M; ++i) {
+      x[i] = rng.randBinomial(n, p);
+      EXPECT_LE(x[i], n);
+      mean += x[i];
+    }
+    mean /= M;
+    for (int i = 0; i < M; ++i) {
+      var += (x[i] - mean) * (x[i] - mean);
+    }
+    var /= M - 1;
+    const double expVar = n * p * (1 - p);
+    EXPECT_NEAR(mean, n * p, 4 * std::sqrt(expVar / M));
+    EXPECT_NEAR(var / expVar, 1, 0.02);
+  }
+  EXPECT_EQ(rng.randBinomial(0, 0.5), 0);
+  EXPECT_EQ(rng.randBinomial(100, 0), 0);
+  EXPECT_EQ(rng.randBinomial(100, 1), 100);
+}
+
+TEST_F(TestSiPMRandom, BinomialDistribution) {
+  sipm::SiPMRandom rng;
+  const int M = 1000000;
+  const uint32_t n = 1000;
+  const double p = 0.3;
+  std::vector<uint32_t> counts(n + 1);
+  for (int i = 0; i < M; ++i) {
+    counts[rng.randBinomial(n, p)]++;
+  }
+  // Compare with the exact pmf, including the tails sampled by BTPE
+  for (uint32_t k = 240; k <= 360; ++k) {
+    const double pmf =
+      std::exp(std::lgamma(n + 1) - std::lgamma(k + 1) - std::lgamma(n - k + 1) + k * log(p) + (n - k) * log(1 - p));
+    EXPECT_NEAR(counts[k], M * pmf, 5 * std::sqrt(M * pmf) + 1) << "k = " << k;
+  }
+}
+
+TEST_F(TestSiPMRandom, Subset) {
+  sipm::SiPMRandom rng;
+  const uint32_t n = 100;
+  const int M = 100000;
+  std::vector<uint64_t> mask((n + 63) / 64);
+  for (const uint32_t k : {0, 1, 10, 90, 100}) {
+    std::vector<uint32_t> counts(n);
+    for (int i = 0; i < M; ++i) {
+      rng.randSubset(n, k, mask.data());
+      uint32_t nSelected = 0;
+      for (uint32_t j = 0; j < n; ++j) {
+        const uint32_t selected = (mask[j / 64] >> (j % 64)) & 1;
+        counts[j] += selected;
+        nSelected += selected;
+      }
+      EXPECT_EQ(nSelected, k);
+      EXPECT_EQ(mask.back() >> (n % 64), 0);
+    }
+    // Each element is selected with probability k / n
+    const double q = static_cast<double>(k) / n;
+    for (uint32_t j = 0; j < n; ++j) {
+      EXPECT_NEAR(counts[j], M * q, 5 * std::sqrt(M * q * (1 - q)) + 1e-9);
+    }
+  }
+}
+
 TEST_F(TestSiPMRandom, RandomCorrelation) {
   sipm::SiPMRandom rng;
   double cov = 0;
@@ -220,3 +454,19 @@ TEST_F(TestSiPMRandom, RandomFCorrelation) {
   cov = cov / (1000 * 1000);
   EXPECT_LE(cov, 0.1);
 }
+
+TEST_F(TestSiPMRandom, CounterBasedEngine) {
+  SiPMRandom rng(SiPMRandom::Engine::kPhilox4x32);
+  EXPECT_TRUE(rng.isCounterBased());
+  EXPECT_FALSE(SiPMRandom().isCounterBased());
+  rng.seed(1234567890);
+  rng.setStream(10, 2);
+  const std::vector<double> first = rng.Rand(1000);
+  const std::vector<float> firstGaussian = rng.randGaussianF(0, 1, 1000);
+  rng.setStream(11, 2);
+  const std::vector<double> other = rng.Rand(1000);
+  rng.setStream(10, 2);
+  EXPECT_EQ(rng.Rand(1000), first);
+  EXPECT_EQ(rng.randGaussianF(0, 1, 1000), firstGaussian);
+  EXPECT_NE(other, first);
+}
@@ -3,6 +3,7 @@
 #include <stdint.h>
 
 #include <iostream>
+#include <sstream>
 
 using namespace sipm;
 
@@ -56,6 +57,70 @@ TEST_F(TestSiPMSensor, AddPhotonsWlen) {
   }
 }
 
+TEST_F(TestSiPMSensor, AddPhotonsPosition) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  // 40 x 40 cells of 25 um centered on the origin
+  sut.setProperties(prop);
+  const std::vector<double> t = {100, 110, 120, 130, 140};
+  const std::vector<double> w = {};
+  const std::vector<double> x = {0.3, -0.4999, 0.4999, 0.6, 0};
+  const std::vector<double> y = {-0.2, -0.4999, 0.4999, 0, -0.51};
+  sut.resetState();
+  sut.addPhotons(t, w, x, y);
+  sut.runEvent();
+  // Last two photons are outside of the sensor
+  ASSERT_EQ(sut.debug().nPhotoelectrons, 3);
+  const SiPMHitStore& hits = sut.hits();
+  EXPECT_EQ(hits.row(0), 12);
+  EXPECT_EQ(hits.col(0), 32);
+  EXPECT_EQ(hits.row(1), 0);
+  EXPECT_EQ(hits.col(1), 0);
+  EXPECT_EQ(hits.row(2), 39);
+  EXPECT_EQ(hits.col(2), 39);
+
+  // Same cells using single precision buffers
+  const std::vector<float> tf(t.begin(), t.end());
+  const std::vector<float> xf(x.begin(), x.end());
+  const std::vector<float> yf(y.begin(), y.end());
+  sut.resetState();
+  sut.addPhotons(tf.data(), nullptr, xf.data(), yf.data(), tf.size());
+  sut.runEvent();
+  ASSERT_EQ(sut.debug().nPhotoelectrons, 3);
+  for (uint32_t i = 0; i < 3; ++i) {
+    EXPECT_EQ(sut.hits().row(i), hits.row(i));
+    EXPECT_EQ(sut.hits().col(i), hits.col(i));
+  }
+}
+
+TEST_F(TestSiPMSensor, PositionSaturation) {
+  SiPMProperties prop;
+  prop.setDcrOff();
+  prop.setXtOff();
+  prop.setApOff();
+  prop.setPde(0.5);
+  sut.setProperties(prop);
+  // All photons in the same cell at the same time: only the first one has
+  // full amplitude, the others hit a cell that is not recovered
+  const uint32_t n = 1000;
+  sut.resetState();
+  for (uint32_t i = 0; i < n; ++i) {
+    sut.addPhoton(100, 450, 0.01, 0.01);
+  }
+  sut.runEvent();
+  const SiPMHitStore& hits = sut.hits();
+  EXPECT_NEAR(sut.debug().nPhotoelectrons, n / 2, 5 * std::sqrt(n * 0.25));
+  double amplitude = 0;
+  for (uint32_t i = 0; i < hits.size(); ++i) {
+    EXPECT_EQ(hits.row(i), 20);
+    EXPECT_EQ(hits.col(i), 20);
+    amplitude += hits.amplitude(i);
+  }
+  EXPECT_LT(amplitude, 2);
+}
+
 TEST_F(TestSiPMSensor, AddDcr) {
   static constexpr int N = 1000000;
   int ndcr = 0;
@@ -98,3 +163,141 @@ TEST_F(TestSiPMSensor, SignalGeneration) {
     EXPECT_LE(avg_peak - 0.5, i);
   }
 }
+
+TEST_F(TestSiPMSensor, HitStore) {
+  static constexpr int N = 10000;
+  for (int i = 0; i < N; ++i) {
+    sut.resetState();
+    const std::vector<double> t = rng.randGaussian(100, 0.1, 50);
+    sut.addPhotons(t);
+    sut.runEvent();
+    const SiPMHitStore& hits = sut.hits();
+    const SiPMDebugInfo debug = sut.debug();
+    EXPECT_EQ(hits.size(), debug.nPhotoelectrons + debug.nAp);
+    for (uint32_t j = 0; j < hits.size(); ++j) {
+      const int32_t parent = hits.parent(j);
+      EXPECT_LT(parent, (int32_t)j);
+      if (hits.hitType(j) == SiPMHit::HitType::kPhotoelectron || hits.hitType(j) == SiPMHit::HitType::kDarkCount) {
+        EXPECT_EQ(parent, SiPMHit::kNoParent);
+      } else {
+        EXPECT_GE(parent, 0);
+        EXPECT_GE(hits.time(j), hits.time(parent));
+      }
+      EXPECT_LT(hits.row(j), sut.properties().nSideCells());
+      EXPECT_LT(hits.col(j), sut.properties().nSideCells());
+    }
+  }
+}
+
+TEST_F(TestSiPMSensor, HitRange) {
+  sut.resetState();
+  sut.addPhotons(rng.randGaussian(100, 0.1, 50));
+  sut.runEvent();
+  const SiPMHitStore& hits = sut.hits();
+  uint32_t i = 0;
+  for (const SiPMHit hit : hits) {
+    EXPECT_EQ(hit.time(), hits.time(i));
+    EXPECT_EQ(hit.amplitude(), hits.amplitude(i));
+    EXPECT_EQ(hit.parent(), hits.parent(i));
+    ++i;
+  }
+  EXPECT_EQ(i, hits.size());
+}
+
+TEST_F(TestSiPMSensor, SignalView) {
+  for (int i = 0; i < 100; ++i) {
+    sut.resetState();
+    sut.addPhotons(rng.randGaussian(50, 1, 20));
+    sut.runEvent();
+    const SiPMAnalogSignal& signal = sut.signal();
+    const SiPMAnalogSignalView view = sut.signalView();
+    EXPECT_EQ(view.data(), signal.waveform().data());
+    EXPECT_EQ(view.size(), signal.size());
+    EXPECT_EQ(view.length(), signal.length());
+    EXPECT_DOUBLE_EQ(signal.length(), signal.size() * signal.sampling());
+    EXPECT_EQ(view.integral(10, 250, 0.5), signal.integral(10, 250, 0.5));
+    EXPECT_EQ(view.peak(10, 250, 0.5), signal.peak(10, 250, 0.5));
+    EXPECT_EQ(view.tot(10, 250, 0.5), signal.tot(10, 250, 0.5));
+    EXPECT_EQ(view.toa(10, 250, 0.5), signal.toa(10, 250, 0.5));
+    EXPECT_EQ(view.top(10, 250, 0.5), signal.top(10, 250, 0.5));
+  }
+}
+
+TEST_F(TestSiPMSensor, SignalLength) {
+  // Length in ns is the number of points times the sampling time
+  const SiPMAnalogSignal signal(std::vector<float>(500), 0.1);
+  EXPECT_DOUBLE_EQ(signal.length(), 50);
+  EXPECT_DOUBLE_EQ(signal.view().length(), 50);
+  std::ostringstream out;
+  out << signal;
+  EXPECT_NE(out.str().find("Signal length is: 50.00 ns"), std::string::npos) << out.str();
+}
+
+TEST_F(TestSiPMSensor, TimeOfPeakThreshold) {
+  const SiPMAnalogSignal signal({0, 0.2f, 1, 3, 2, 0.5f, 0, 0, 0, 0}, 0.1);
+  EXPECT_DOUBLE_EQ(signal.top(0, 1, 0.5), 0.3);
+  EXPECT_DOUBLE_EQ(signal.top(0.1, 0.9, 0.5), 0.2);
+  // Signal below the threshold
+  EXPECT_EQ(signal.top(0, 1, 5), -1);
+  EXPECT_EQ(signal.top(0.7, 0.3, 0.5), -1);
+}
+
+TEST_F(TestSiPMSensor, TakeSignal) {
+  SiPMSensor sensor;
+  sensor.runEvent();
+  SiPMAnalogSignal first = sensor.takeSignal();
+  EXPECT_EQ(first.size(), sensor.properties().nSignalPoints());
+  EXPECT_EQ(sensor.signal().size(), 0);
+
+  // Recycled buffer is used by the next event
+  const float* data = first.waveform().data();
+  sensor.recycleSignal(std::move(first));
+  sensor.runEvent();
+  SiPMAnalogSignal second = sensor.takeSignal();
+  EXPECT_EQ(second.size(), sensor.properties().nSignalPoints());
+  sensor.runEvent();
+  EXPECT_EQ(second.waveform().data(), data);
+  EXPECT_NE(sensor.signal().waveform().data(), data);
+}
+
+TEST_F(TestSiPMSensor, RunEvents) {
+  static constexpr int N = 25;
+  static constexpr int R = 1000;
+  SiPMSensor sensor;
+  auto prop = sensor.properties();
+  prop.setXtOff();
+  prop.setDcrOff();
+  prop.setApOff();
+  prop.setSnr(40);
+  sensor.setProperties(prop);
+  const uint32_t nSignalPoints = prop.nSignalPoints();
+
+  // Event i has i + 1 photons
+  std::vector<double> times;
+  std::vector<uint32_t> offsets = {0};
+  for (int i = 0; i < N; ++i) {
+    const std::vector<double> t = rng.randGaussian(10, 0.1, i + 1);
+    times.insert(times.end(), t.begin(), t.end());
+    offsets.push_back(times.size());
+  }
+
+  std::vector<float> signals(N * nSignalPoints);
+  std::vector<SiPMDebugInfo> debugs(N);
+  std::vector<double> avgPeak(N, 0);
+  for (int r = 0; r < R; ++r) {
+    sensor.runEvents(times, offsets, signals.data(), debugs.data());
+    for (int i = 0; i < N; ++i) {
+      EXPECT_EQ(debugs[i].nPhotons, i + 1);
+      EXPECT_EQ(debugs[i].nPhotoelectrons, i + 1);
+      const SiPMAnalogSignal signal(
+        std::vector<float>(signals.begin() + i * nSignalPoints, signals.begin() + (i + 1) * nSignalPoints),
+        prop.sampling());
+      avgPeak[i] += signal.peak(0, 20, 0);
+    }
+  }
+  for (int i = 0; i < N; ++i) {
+    avgPeak[i] /= R;
+    EXPECT_GE(avgPeak[i] + 0.5, i + 1);
+    EXPECT_LE(avgPeak[i] - 0.5, i + 1);
+  }
+}
@@ -12,18 +12,11 @@ TEST_F(TestSiPMXorshift256, Constructor) { uint64_t N = 10000000; }
 TEST_F(TestSiPMXorshift256, Seed) {
   sipm::SiPMRng::Xorshift256plus rng;
   static constexpr uint64_t seed = 1234567890UL; // Random seed
-#ifdef __AVX512F__
-  static constexpr uint64_t expected[] = {3539951786562994468ULL,  16993425385450634633ULL, 12425995393443937258ULL,
-                                          1971016958421006117ULL,  3113309500227661404ULL,  490387842609610270ULL,
-                                          11577763190126509135ULL, 18038816835264277783ULL, 14056837810899630979ULL,
-                                          8986600062506074549ULL};
-#else
-
- static constexpr uint64_t expected[] = {2356680413504073166ULL, 6439555299326541142ULL, 13107374383302832124ULL,
-                                          15371213951372998008ULL, 3598216317549022935ULL, 9944474804087195216ULL,
-                                          1783072794770156681ULL, 9432686255404415156ULL, 5598578073076770953ULL,
-                                          11053698116263360353};
-#endif
+  // Same stream for every backend of SiPMDispatch
+  static constexpr uint64_t expected[] = {3539951786562994468ULL,  18076350524896360473ULL, 10392609801079207211ULL,
+                                          12130973169000346980ULL, 10312767049707617290ULL, 9729539824700895057ULL,
+                                          10453342588227067794ULL, 13347685783319845425ULL, 14056837810899630979ULL,
+                                          420466879862129606ULL};
   rng.seed(seed);
   for (int j = 0; j < 10; ++j) {
     uint64_t x = rng();
@@ -119,3 +112,53 @@ TEST_F(TestSiPMXorshift256, GenerationBigWindowTest) {
     }
   }
 }
+
+TEST_F(TestSiPMXorshift256, Jump) {
+  static constexpr int n = 64;
+  uint64_t first_run[n];
+  uint64_t second_run[n];
+  uint64_t tmp;
+  sipm::SiPMRng::Xorshift256plus rng(1234567890);
+  sipm::SiPMRng::Xorshift256plus other(rng);
+
+  // Jump polynomial commutes with generator step
+  rng.getRand(&tmp, 1);
+  rng.jump();
+  rng.getRand(first_run, n);
+  other.jump();
+  other.getRand(&tmp, 1);
+  other.getRand(second_run, n);
+  for (int i = 0; i < n; ++i) {
+    EXPECT_EQ(first_run[i], second_run[i]) << ">> Jump does not commute with generator step";
+  }
+
+  // Same for long jump
+  rng.getRand(&tmp, 1);
+  rng.long_jump();
+  rng.getRand(first_run, n);
+  other.long_jump();
+  other.getRand(&tmp, 1);
+  other.getRand(second_run, n);
+  for (int i = 0; i < n; ++i) {
+    EXPECT_EQ(first_run[i], second_run[i]) << ">> Long jump does not commute with generator step";
+  }
+}
+
+TEST_F(TestSiPMXorshift256, Split) {
+  static constexpr int n = 1024;
+  sipm::SiPMRng::Xorshift256plus rng(1234567890);
+  sipm::SiPMRng::Xorshift256plus jumped(rng);
+  jumped.jump();
+  jumped.jump();
+
+  sipm::SiPMRng::Xorshift256plus first = rng.split(0);
+  sipm::SiPMRng::Xorshift256plus second = rng.split(2);
+  sipm::SiPMRng::Xorshift256plus third = rng.split(2);
+  for (int i = 0; i < n; ++i) {
+    const uint64_t x0 = first();
+    const uint64_t x2 = second();
+    EXPECT_NE(x0, x2) << ">> Different substreams produced same values";
+    EXPECT_EQ(x2, third()) << ">> Split is not reproducible";
+    EXPECT_EQ(x2, jumped()) << ">> Split is not equivalent to k jumps";
+  }
+}